@@ -0,0 +1,67 @@
+# Copyright 2012 Cloudera Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# - Find ZSTD (zstd.h, libzstd.a, libzstd.so, and libzstd.so.1)
+# This module defines
+#  ZSTD_INCLUDE_DIR, directory containing headers
+#  ZSTD_LIBS, directory containing zstd libraries
+#  ZSTD_STATIC_LIB, path to libzstd.a
+#  ZSTD_FOUND, whether zstd has been found
+
+set(ZSTD_SEARCH_HEADER_PATHS
+  ${THIRDPARTY_PREFIX}/include
+)
+
+set(ZSTD_SEARCH_LIB_PATH
+  ${THIRDPARTY_PREFIX}/lib
+)
+
+find_path(ZSTD_INCLUDE_DIR zstd.h PATHS
+  ${ZSTD_SEARCH_HEADER_PATHS}
+  # make sure we don't accidentally pick up a different version
+  NO_DEFAULT_PATH
+)
+
+find_library(ZSTD_LIB_PATH NAMES zstd PATHS ${ZSTD_SEARCH_LIB_PATH} NO_DEFAULT_PATH)
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIB_PATH)
+  set(ZSTD_FOUND TRUE)
+  set(ZSTD_LIBS ${ZSTD_SEARCH_LIB_PATH})
+  set(ZSTD_STATIC_LIB ${ZSTD_SEARCH_LIB_PATH}/libzstd.a)
+else ()
+  set(ZSTD_FOUND FALSE)
+endif ()
+
+if (ZSTD_FOUND)
+  if (NOT Zstd_FIND_QUIETLY)
+    message(STATUS "Found the Zstd library: ${ZSTD_LIB_PATH}")
+  endif ()
+else ()
+  if (NOT Zstd_FIND_QUIETLY)
+    set(ZSTD_ERR_MSG "Could not find the Zstd library. Looked for headers")
+    set(ZSTD_ERR_MSG "${ZSTD_ERR_MSG} in ${ZSTD_SEARCH_HEADER_PATHS}, and for libs")
+    set(ZSTD_ERR_MSG "${ZSTD_ERR_MSG} in ${ZSTD_SEARCH_LIB_PATH}")
+    if (Zstd_FIND_REQUIRED)
+      message(FATAL_ERROR "${ZSTD_ERR_MSG}")
+    else (Zstd_FIND_REQUIRED)
+      message(STATUS "${ZSTD_ERR_MSG}")
+    endif (Zstd_FIND_REQUIRED)
+  endif ()
+endif ()
+
+mark_as_advanced(
+  ZSTD_INCLUDE_DIR
+  ZSTD_LIBS
+  ZSTD_STATIC_LIB
+)
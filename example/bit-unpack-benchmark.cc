@@ -0,0 +1,93 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "impala/bit-packing.h"
+#include "impala/cpu-info.h"
+#include "impala/bit-stream-utils.inline.h"
+#include "util/stopwatch.h"
+
+using namespace impala;
+using namespace parquet_cpp;
+using namespace std;
+
+// Measures the throughput of the bit unpacking kernels for each bit width, next to
+// decoding the same values one at a time with BitReader::GetValue().
+
+typedef const uint8_t* (*UnpackFn)(const uint8_t* in, uint32_t* out, int num_bits);
+
+const int NUM_VALUES = 1024 * 1024;
+const int NUM_ITERS = 20;
+
+double ValuesPerSec(uint64_t elapsed_ns) {
+  return NUM_VALUES * static_cast<double>(NUM_ITERS) / (elapsed_ns / 1e9);
+}
+
+double BenchmarkGetValue(const vector<uint8_t>& packed, int num_bits,
+    uint32_t* values) {
+  StopWatch sw;
+  sw.Start();
+  for (int iter = 0; iter < NUM_ITERS; ++iter) {
+    BitReader reader(&packed[0], packed.size());
+    for (int i = 0; i < NUM_VALUES; ++i) {
+      reader.GetValue(num_bits, &values[i]);
+    }
+  }
+  return ValuesPerSec(sw.Stop());
+}
+
+double BenchmarkUnpack(UnpackFn fn, const vector<uint8_t>& packed, int num_bits,
+    uint32_t* values) {
+  StopWatch sw;
+  sw.Start();
+  for (int iter = 0; iter < NUM_ITERS; ++iter) {
+    const uint8_t* in = &packed[0];
+    for (int i = 0; i < NUM_VALUES; i += 32) {
+      in = fn(in, values + i, num_bits);
+    }
+  }
+  return ValuesPerSec(sw.Stop());
+}
+
+int main(int argc, char** argv) {
+  bool avx2 = CpuInfo::SupportsAvx2();
+  vector<uint32_t> values(NUM_VALUES);
+
+  printf("Values/sec (millions) decoding %d values %d times\n", NUM_VALUES, NUM_ITERS);
+  printf("%5s %10s %10s %10s %10s\n", "width", "GetValue", "scalar", "sse", "avx2");
+  for (int num_bits = 1; num_bits <= 32; ++num_bits) {
+    vector<uint8_t> packed(NUM_VALUES / 8 * num_bits);
+    BitWriter writer(&packed[0], packed.size());
+    uint64_t mask = (1ULL << num_bits) - 1;
+    for (int i = 0; i < NUM_VALUES; ++i) {
+      writer.PutValue(rand() & mask, num_bits);
+    }
+    writer.Flush();
+
+    printf("%5d %10.1f %10.1f %10.1f", num_bits,
+        BenchmarkGetValue(packed, num_bits, &values[0]) / 1e6,
+        BenchmarkUnpack(BitPacking::Unpack32Scalar, packed, num_bits, &values[0]) / 1e6,
+        BenchmarkUnpack(BitPacking::Unpack32Sse, packed, num_bits, &values[0]) / 1e6);
+    if (avx2) {
+      printf(" %10.1f\n",
+          BenchmarkUnpack(BitPacking::Unpack32Avx2, packed, num_bits, &values[0]) / 1e6);
+    } else {
+      printf(" %10s\n", "n/a");
+    }
+  }
+  return 0;
+}
@@ -12,27 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <parquet/file-reader.h>
 #include <parquet/parquet.h>
 #include <iostream>
 #include <stdio.h>
-
-#include "example_util.h"
+#include <string.h>
 
 using namespace boost;
 using namespace parquet;
 using namespace parquet_cpp;
 using namespace std;
 
-struct AnyType {
-  union {
-    bool bool_val;
-    int32_t int32_val;
-    int64_t int64_val;
-    float float_val;
-    double double_val;
-    ByteArray byte_array_val;
-  };
-};
+// Number of levels/values read from the column reader per call.
+const int BATCH_SIZE = 1024;
 
 static string ByteArrayToString(const ByteArray& a) {
   return string(reinterpret_cast<const char*>(a.ptr), a.len);
@@ -47,181 +39,139 @@ int ByteCompare(const ByteArray& x1, const ByteArray& x2) {
   return 0;
 }
 
+template <typename T>
+bool LessThan(const T& x1, const T& x2) { return x1 < x2; }
+
+template <>
+bool LessThan(const ByteArray& x1, const ByteArray& x2) {
+  return ByteCompare(x1, x2) < 0;
+}
+
+template <typename T>
+void PrintValue(const char* label, const T& v) {
+  cout << label << v << endl;
+}
+
+template <>
+void PrintValue(const char* label, const ByteArray& v) {
+  cout << label << ByteArrayToString(v) << endl;
+}
+
+// Reads all the values in 'reader' and prints the number of values, number of
+// nulls and min/max.
+template <typename ReaderType>
+void ComputeStats(ReaderType* reader) {
+  typedef typename ReaderType::T T;
+  int16_t def_levels[BATCH_SIZE];
+  int16_t rep_levels[BATCH_SIZE];
+  const T* values;
+
+  bool first_val = true;
+  T min = T(), max = T();
+  int64_t num_values = 0;
+  int64_t num_nulls = 0;
+
+  while (reader->HasNext()) {
+    int64_t values_read = 0;
+    int64_t levels_read = reader->ReadBatchZeroCopy(
+        BATCH_SIZE, def_levels, rep_levels, &values, &values_read);
+    for (int64_t i = 0; i < values_read; ++i) {
+      if (first_val) {
+        min = max = values[i];
+        first_val = false;
+      } else {
+        if (LessThan(values[i], min)) min = values[i];
+        if (LessThan(max, values[i])) max = values[i];
+      }
+    }
+    num_values += values_read;
+    num_nulls += levels_read - values_read;
+  }
+
+  cout << "  Num Values: " << num_values << endl;
+  cout << "  Num Nulls: " << num_nulls << endl;
+  PrintValue("  Min: ", min);
+  PrintValue("  Max: ", max);
+}
+
 // Simple example which reads all the values in the file and outputs the number of
 // values, number of nulls and min/max for each column.
+// With --mmap, the file is memory mapped, and with --io_uring, the column chunks of
+// each row group are read as one io_uring batch, instead of using pread().
 int main(int argc, char** argv) {
+  ParquetFileReader::IoMode io_mode = ParquetFileReader::PREAD;
+  if (argc > 1 && strcmp(argv[1], "--mmap") == 0) {
+    io_mode = ParquetFileReader::MMAP;
+    --argc;
+    ++argv;
+  } else if (argc > 1 && strcmp(argv[1], "--io_uring") == 0) {
+    io_mode = ParquetFileReader::IO_URING;
+    --argc;
+    ++argv;
+  }
   int col_idx = -1;
   if (argc < 2) {
-    cerr << "Usage: compute_stats <file> [col_idx]" << endl;
+    cerr << "Usage: compute_stats [--mmap|--io_uring] <file> [col_idx]" << endl;
     return -1;
   }
   if (argc == 3) col_idx = atoi(argv[2]);
-  FileMetaData metadata;
-  if (!GetFileMetadata(argv[1], &metadata)) return -1;
 
-  FILE* file = fopen(argv[1], "r");
-  if (file == NULL) {
-    cerr << "Could not open file: " << argv[1] << endl;
+  shared_ptr<ParquetFileReader> file;
+  try {
+    file = ParquetFileReader::Open(argv[1], io_mode);
+  } catch (const ParquetException& e) {
+    cerr << e.what() << endl;
     return -1;
   }
+  IoUringSource* io_uring_source = dynamic_cast<IoUringSource*>(file->source());
+  if (io_uring_source != NULL && !io_uring_source->io_uring_enabled()) {
+    cerr << "io_uring is not available, reading with pread()" << endl;
+  }
+  const FileMetaData& metadata = file->metadata();
+
+  for (int i = 0; i < file->num_row_groups(); ++i) {
+    shared_ptr<RowGroupReader> row_group = file->RowGroup(i);
+    // Read all the chunks needed with as few reads as possible.
+    vector<int> columns;
+    for (int c = 0; c < row_group->num_columns(); ++c) {
+      if (col_idx == -1 || col_idx == c) columns.push_back(c);
+    }
+    row_group->LoadColumns(columns);
 
-  shared_ptr<Schema> schema = Schema::FromParquet(metadata.schema);
-
-  for (int i = 0; i < metadata.row_groups.size(); ++i) {
-    const RowGroup& row_group = metadata.row_groups[i];
-    for (int c = 0; c < row_group.columns.size(); ++c) {
+    for (int c = 0; c < row_group->num_columns(); ++c) {
       if (col_idx != -1 && col_idx != c) continue;
-      const ColumnChunk& col = row_group.columns[c];
+      const ColumnMetaData& col = row_group->column_metadata(c);
       cout << "Reading column " << metadata.schema[c + 1].name << " (idx=" << c << ")\n";
-      if (col.meta_data.type == Type::INT96) {
+      if (col.type == Type::INT96) {
         cout << "  Skipping unsupported column" << endl;
         continue;
       }
 
-      size_t col_start = col.meta_data.data_page_offset;
-      if (col.meta_data.__isset.dictionary_page_offset) {
-        if (col_start > col.meta_data.dictionary_page_offset) {
-          col_start = col.meta_data.dictionary_page_offset;
-        }
-      }
-      fseek(file, col_start, SEEK_SET);
-      vector<uint8_t> column_buffer;
-      column_buffer.resize(col.meta_data.total_compressed_size);
-      size_t num_read = fread(&column_buffer[0], 1, column_buffer.size(), file);
-      if (num_read != column_buffer.size()) {
-        cerr << "Could not read column data." << endl;
-        continue;
-      }
-
-      InMemoryInputStream input(&column_buffer[0], column_buffer.size());
-      ColumnReader reader(&col.meta_data, schema->leaves()[c], &input);
-
-      bool first_val = true;
-      AnyType min, max;
-      int num_values = 0;
-      int num_nulls = 0;
-
-      bool is_null;
-      int def_level, rep_level;
-      while (reader.HasNext()) {
-        switch (col.meta_data.type) {
-          case Type::BOOLEAN: {
-            bool val = reader.GetBool(&is_null, &def_level, &rep_level);
-            if (is_null) continue;
-            if (first_val) {
-              min.bool_val = max.bool_val = val;
-              first_val = false;
-            } else {
-              min.bool_val = ::min(val, min.bool_val);
-              max.bool_val = ::max(val, max.bool_val);
-            }
-            break;
-          }
-          case Type::INT32: {
-            int32_t val = reader.GetInt32(&is_null, &def_level, &rep_level);;
-            if (is_null) continue;
-            if (first_val) {
-              min.int32_val = max.int32_val = val;
-              first_val = false;
-            } else {
-              min.int32_val = ::min(val, min.int32_val);
-              max.int32_val = ::max(val, max.int32_val);
-            }
-            break;
-          }
-          case Type::INT64: {
-            int64_t val = reader.GetInt64(&is_null, &def_level, &rep_level);;
-            if (is_null) continue;
-            if (def_level < rep_level) break;
-            if (first_val) {
-              min.int64_val = max.int64_val = val;
-              first_val = false;
-            } else {
-              min.int64_val = ::min(val, min.int64_val);
-              max.int64_val = ::max(val, max.int64_val);
-            }
-            break;
-          }
-          case Type::FLOAT: {
-            float val = reader.GetFloat(&is_null, &def_level, &rep_level);;
-            if (is_null) continue;
-            if (first_val) {
-              min.float_val = max.float_val = val;
-              first_val = false;
-            } else {
-              min.float_val = ::min(val, min.float_val);
-              max.float_val = ::max(val, max.float_val);
-            }
-            break;
-          }
-          case Type::DOUBLE: {
-            double val = reader.GetDouble(&is_null, &def_level, &rep_level);;
-            if (is_null) continue;
-            if (first_val) {
-              min.double_val = max.double_val = val;
-              first_val = false;
-            } else {
-              min.double_val = ::min(val, min.double_val);
-              max.double_val = ::max(val, max.double_val);
-            }
-            break;
-          }
-          case Type::BYTE_ARRAY: {
-            ByteArray val = reader.GetByteArray(&is_null, &def_level, &rep_level);;
-            if (is_null) continue;
-            if (first_val) {
-              min.byte_array_val = max.byte_array_val = val;
-              first_val = false;
-            } else {
-              if (ByteCompare(val, min.byte_array_val) < 0) {
-                min.byte_array_val = val;
-              }
-              if (ByteCompare(val, max.byte_array_val) > 0) {
-                max.byte_array_val = val;
-              }
-            }
-            break;
-          }
-          default:
-            continue;
-        }
-
-        if (is_null) ++num_nulls;
-        ++num_values;
-      }
+      shared_ptr<ColumnReader> reader = row_group->Column(c);
 
-      cout << "  Num Values: " << num_values << endl;
-      cout << "  Num Nulls: " << num_nulls << endl;
-      switch (col.meta_data.type) {
+      switch (col.type) {
         case Type::BOOLEAN:
-          cout << "  Min: " << min.bool_val << endl;
-          cout << "  Max: " << max.bool_val << endl;
+          ComputeStats(static_cast<BoolReader*>(reader.get()));
           break;
         case Type::INT32:
-          cout << "  Min: " << min.int32_val << endl;
-          cout << "  Max: " << max.int32_val << endl;
+          ComputeStats(static_cast<Int32Reader*>(reader.get()));
           break;
         case Type::INT64:
-          cout << "  Min: " << min.int64_val << endl;
-          cout << "  Max: " << max.int64_val << endl;
+          ComputeStats(static_cast<Int64Reader*>(reader.get()));
           break;
         case Type::FLOAT:
-          cout << "  Min: " << min.float_val << endl;
-          cout << "  Max: " << max.float_val << endl;
+          ComputeStats(static_cast<FloatReader*>(reader.get()));
           break;
         case Type::DOUBLE:
-          cout << "  Min: " << min.double_val << endl;
-          cout << "  Max: " << max.double_val << endl;
+          ComputeStats(static_cast<DoubleReader*>(reader.get()));
           break;
         case Type::BYTE_ARRAY:
-          cout << "  Min: " << ByteArrayToString(min.byte_array_val) << endl;
-          cout << "  Max: " << ByteArrayToString(max.byte_array_val) << endl;
+          ComputeStats(static_cast<ByteArrayReader*>(reader.get()));
           break;
         default:
           continue;
       }
     }
   }
-  fclose(file);
   return 0;
 }
@@ -16,7 +16,6 @@
 #include <iostream>
 #include <stdio.h>
 
-#include "example_util.h"
 #include "compression/codec.h"
 #include "encodings/encodings.h"
 #include "util/stopwatch.h"
@@ -33,7 +32,7 @@ using namespace std;
 
 uint64_t TestPlainIntEncoding(const uint8_t* data, int num_values, int batch_size) {
   uint64_t result = 0;
-  PlainDecoder decoder(Type::INT64);
+  PlainDecoder<Type::INT64> decoder;
   decoder.SetData(num_values, data, num_values * sizeof(int64_t));
   int64_t values[batch_size];
   for (int i = 0; i < num_values;) {
@@ -283,6 +282,8 @@ int main(int argc, char** argv) {
 
   SnappyCodec snappy_codec;
   Lz4Codec lz4_codec;
+  GzipCodec gzip_codec;
+  ZstdCodec zstd_codec;
 
   TestPlainIntCompressed(&snappy_codec, values, 100, 1);
   TestPlainIntCompressed(&snappy_codec, values, 100, 16);
@@ -294,5 +295,15 @@ int main(int argc, char** argv) {
   TestPlainIntCompressed(&lz4_codec, values, 100, 32);
   TestPlainIntCompressed(&lz4_codec, values, 100, 64);
 
+  TestPlainIntCompressed(&gzip_codec, values, 100, 1);
+  TestPlainIntCompressed(&gzip_codec, values, 100, 16);
+  TestPlainIntCompressed(&gzip_codec, values, 100, 32);
+  TestPlainIntCompressed(&gzip_codec, values, 100, 64);
+
+  TestPlainIntCompressed(&zstd_codec, values, 100, 1);
+  TestPlainIntCompressed(&zstd_codec, values, 100, 16);
+  TestPlainIntCompressed(&zstd_codec, values, 100, 32);
+  TestPlainIntCompressed(&zstd_codec, values, 100, 64);
+
   return 0;
 }
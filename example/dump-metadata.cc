@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <parquet/file-reader.h>
 #include <parquet/parquet.h>
 #include <parquet/schema.h>
 
@@ -19,26 +20,20 @@
 #include <iostream>
 #include <stdio.h>
 
-#include "example_util.h"
-
 using namespace boost;
 using namespace parquet;
 using namespace parquet_cpp;
 using namespace std;
 
 void DumpMetadata(char* filename) {
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    cerr << "Could not open file: " << filename << endl;
-    return;
-  }
-
-  FileMetaData metadata;
-  if (!GetFileMetadata(filename, &metadata)) {
-    cerr << "Could not parse file metadata.";
-    fclose(file);
+  shared_ptr<ParquetFileReader> file;
+  try {
+    file = ParquetFileReader::Open(filename);
+  } catch (const ParquetException& e) {
+    cerr << e.what() << endl;
     return;
   }
+  const FileMetaData& metadata = file->metadata();
 
   cout << "Metadata for file: " << filename << endl;
   cout << "  Version: " << metadata.version << endl;
@@ -58,7 +53,7 @@ void DumpMetadata(char* filename) {
     }
   }
 
-  shared_ptr<Schema> schema = Schema::FromParquet(metadata.schema);
+  const Schema* schema = file->schema();
   cout << "Schema:\n" << schema->ToString() << endl;
   cout << "Num leaf columns: "  << schema->leaves().size() << endl;
   cout << "Max depth: " << schema->max_def_level() << endl;
@@ -0,0 +1,97 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <vector>
+
+#include <parquet/page-header.h>
+#include <parquet/parquet.h>
+#include "util/stopwatch.h"
+
+using namespace parquet;
+using namespace parquet_cpp;
+using namespace std;
+
+// Measures how fast page headers are deserialized by thrift (DeserializeThriftMsg())
+// and by the hand written parser (DeserializePageHeader()).
+
+const int NUM_ITERS = 1000 * 1000;
+
+typedef void (*DeserializeFn)(const uint8_t* buf, uint32_t* len, PageHeader* header);
+
+void DeserializeWithThrift(const uint8_t* buf, uint32_t* len, PageHeader* header) {
+  DeserializeThriftMsg(buf, len, header);
+}
+
+double HeadersPerSec(DeserializeFn fn, const vector<uint8_t>& bytes) {
+  PageHeader header;
+  StopWatch sw;
+  sw.Start();
+  for (int i = 0; i < NUM_ITERS; ++i) {
+    uint32_t len = bytes.size();
+    fn(&bytes[0], &len, &header);
+  }
+  return NUM_ITERS / (sw.Stop() / 1e9);
+}
+
+vector<uint8_t> Serialize(const PageHeader& header) {
+  boost::shared_ptr<apache::thrift::transport::TMemoryBuffer> mem(
+      new apache::thrift::transport::TMemoryBuffer());
+  apache::thrift::protocol::TCompactProtocolT<
+      apache::thrift::transport::TMemoryBuffer> protocol(mem);
+  header.write(&protocol);
+  uint8_t* bytes;
+  uint32_t len;
+  mem->getBuffer(&bytes, &len);
+  return vector<uint8_t>(bytes, bytes + len);
+}
+
+void Benchmark(const char* name, const PageHeader& header) {
+  vector<uint8_t> bytes = Serialize(header);
+  printf("%-25s %6d %10.2f %10.2f\n", name, static_cast<int>(bytes.size()),
+      HeadersPerSec(DeserializeWithThrift, bytes) / 1e6,
+      HeadersPerSec(DeserializePageHeader, bytes) / 1e6);
+}
+
+int main(int argc, char** argv) {
+  PageHeader header;
+  header.type = PageType::DATA_PAGE;
+  header.uncompressed_page_size = 8 * 1024;
+  header.compressed_page_size = 4 * 1024;
+  header.data_page_header.num_values = 1024;
+  header.data_page_header.encoding = Encoding::PLAIN_DICTIONARY;
+  header.data_page_header.definition_level_encoding = Encoding::RLE;
+  header.data_page_header.repetition_level_encoding = Encoding::BIT_PACKED;
+  header.__isset.data_page_header = true;
+
+  printf("Headers/sec (millions) deserializing %d times\n", NUM_ITERS);
+  printf("%-25s %6s %10s %10s\n", "header", "bytes", "thrift", "parser");
+  Benchmark("Data page", header);
+
+  header.data_page_header.statistics.__set_min("aaaaaaaa");
+  header.data_page_header.statistics.__set_max("zzzzzzzz");
+  header.data_page_header.statistics.__set_null_count(10);
+  header.data_page_header.__isset.statistics = true;
+  Benchmark("Data page with stats", header);
+
+  PageHeader dictionary_header;
+  dictionary_header.type = PageType::DICTIONARY_PAGE;
+  dictionary_header.uncompressed_page_size = 64 * 1024;
+  dictionary_header.compressed_page_size = 32 * 1024;
+  dictionary_header.dictionary_page_header.num_values = 1000;
+  dictionary_header.dictionary_page_header.encoding = Encoding::PLAIN;
+  dictionary_header.__isset.dictionary_page_header = true;
+  Benchmark("Dictionary page", dictionary_header);
+  return 0;
+}
@@ -12,11 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <parquet/file-reader.h>
 #include <parquet/parquet.h>
 #include <iostream>
 #include <stdio.h>
-
-#include "example_util.h"
+#include <string.h>
 
 // the fixed initial size is just for an example
 #define INIT_SIZE 100
@@ -42,17 +42,87 @@ static string ByteArrayToString(const ByteArray& a) {
   return string(reinterpret_cast<const char*>(a.ptr), a.len);
 }
 
-void* read_parquet(char* filename);
+// Number of levels/values read from the column reader per call.
+const int BATCH_SIZE = 128;
+
+// Copies out the bytes of the value; the column buffer does not outlive the reader.
+template <typename T>
+T CopyValue(const T& v) { return v; }
+
+template <>
+ByteArray CopyValue(const ByteArray& v) {
+  ByteArray result;
+  result.len = v.len;
+  result.ptr = new uint8_t[v.len];
+  memcpy((char*)result.ptr, v.ptr, v.len);
+  return result;
+}
+
+// Reads up to 'max_rows' entries of 'reader' into 'dst', one per row. NULLs are
+// returned as T(). Returns the number of entries read.
+template <typename ReaderType>
+int ReadColumn(ReaderType* reader, typename ReaderType::T* dst, int max_rows) {
+  typedef typename ReaderType::T T;
+  int16_t def_levels[BATCH_SIZE];
+  int num_rows = 0;
+
+  if (reader->max_rep_level() == 0) {
+    // Flat column: read the values straight into their row slots.
+    vector<uint8_t> valid_bits(impala::BitUtil::BytesForBits(max_rows));
+    while (reader->HasNext() && num_rows < max_rows) {
+      int64_t null_count = 0;
+      int64_t levels_read = reader->ReadBatchSpaced(
+          ::min(BATCH_SIZE, max_rows - num_rows), def_levels, dst + num_rows,
+          &valid_bits[0], num_rows, &null_count);
+      for (int64_t i = num_rows; i < num_rows + levels_read; ++i) {
+        dst[i] = impala::BitUtil::GetBit(&valid_bits[0], i) ? CopyValue(dst[i]) : T();
+      }
+      num_rows += levels_read;
+    }
+    return num_rows;
+  }
+
+  int16_t rep_levels[BATCH_SIZE];
+  T values[BATCH_SIZE];
+  while (reader->HasNext() && num_rows < max_rows) {
+    int64_t values_read = 0;
+    int64_t levels_read = reader->ReadBatch(::min(BATCH_SIZE, max_rows - num_rows),
+        def_levels, rep_levels, values, &values_read);
+    int value_idx = 0;
+    for (int64_t i = 0; i < levels_read; ++i) {
+      if (reader->max_def_level() == 0 || def_levels[i] == reader->max_def_level()) {
+        dst[num_rows++] = CopyValue(values[value_idx++]);
+      } else {
+        dst[num_rows++] = T();
+      }
+    }
+  }
+  return num_rows;
+}
 
-// Simple example which prints out the content of the Parquet file
+void* read_parquet(char* filename, ParquetFileReader::IoMode io_mode);
+
+// Simple example which prints out the content of the Parquet file.
+// With --mmap, the file is memory mapped, and with --io_uring, the column chunks of
+// each row group are read as one io_uring batch, instead of using pread().
 int main(int argc, char** argv) {
+  ParquetFileReader::IoMode io_mode = ParquetFileReader::PREAD;
+  if (argc > 1 && strcmp(argv[1], "--mmap") == 0) {
+    io_mode = ParquetFileReader::MMAP;
+    --argc;
+    ++argv;
+  } else if (argc > 1 && strcmp(argv[1], "--io_uring") == 0) {
+    io_mode = ParquetFileReader::IO_URING;
+    --argc;
+    ++argv;
+  }
 
   if (argc < 2) {
-    cerr << "Usage: parquet_reader <file>" << endl;
+    cerr << "Usage: parquet_reader [--mmap|--io_uring] <file>" << endl;
     return -1;
   }
 
-  void *column_ptr = read_parquet(argv[1]);
+  void *column_ptr = read_parquet(argv[1], io_mode);
 
   // an example to use the returned column_ptr
   // printf("%-"COL_WIDTH"d\n",((int32_t *)(((int32_t **)column_ptr)[0]))[0]);
@@ -61,23 +131,30 @@ int main(int argc, char** argv) {
 }
 
 
-void* read_parquet(char* filename) {
+void* read_parquet(char* filename, ParquetFileReader::IoMode io_mode) {
 
   unsigned int total_row_number = 0;
 
-  FileMetaData metadata;
-  if (!GetFileMetadata(filename, &metadata)) return NULL;
-
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    cerr << "Could not open file: " << filename << endl;
+  shared_ptr<ParquetFileReader> file;
+  try {
+    file = ParquetFileReader::Open(filename, io_mode);
+  } catch (const ParquetException& e) {
+    cerr << e.what() << endl;
     return NULL;
   }
-
-  shared_ptr<Schema> schema = Schema::FromParquet(metadata.schema);
+  IoUringSource* io_uring_source = dynamic_cast<IoUringSource*>(file->source());
+  if (io_uring_source != NULL && !io_uring_source->io_uring_enabled()) {
+    cerr << "io_uring is not available, reading with pread()" << endl;
+  }
+  const FileMetaData& metadata = file->metadata();
 
   for (int i = 0; i < metadata.row_groups.size(); ++i) {
     const RowGroup& row_group = metadata.row_groups[i];
+    shared_ptr<RowGroupReader> row_group_reader = file->RowGroup(i);
+    // Read all the chunks with as few reads as possible.
+    vector<int> columns;
+    for (int c = 0; c < row_group.columns.size(); ++c) columns.push_back(c);
+    row_group_reader->LoadColumns(columns);
 
     Type::type* type_array = (Type::type*)malloc(
         row_group.columns.size() * sizeof(Type::type));
@@ -95,27 +172,10 @@ void* read_parquet(char* filename) {
         continue;
       }
 
-      size_t col_start = col.meta_data.data_page_offset;
-      if (col.meta_data.__isset.dictionary_page_offset) {
-        if (col_start > col.meta_data.dictionary_page_offset) {
-          col_start = col.meta_data.dictionary_page_offset;
-        }
-      }
-      fseek(file, col_start, SEEK_SET);
-      vector<uint8_t> column_buffer;
-      column_buffer.resize(col.meta_data.total_compressed_size);
-      size_t num_read = fread(&column_buffer[0], 1, column_buffer.size(), file);
-      if (num_read != column_buffer.size()) {
-        cerr << "Could not read column data." << endl;
-        continue;
-      }
-
-      InMemoryInputStream input(&column_buffer[0], column_buffer.size());
-      ColumnReader reader(&col.meta_data, schema->leaves()[c], &input);
+      shared_ptr<ColumnReader> reader = row_group_reader->Column(c);
 
       AnyType min, max;
       int num_values = 0;
-      int num_nulls = 0;
 
       switch (col.meta_data.type) {
         case Type::BOOLEAN: {
@@ -156,55 +216,33 @@ void* read_parquet(char* filename) {
           break;
       }
 
-      bool is_null;
-      int def_level = 0, rep_level = 0;
-      while (reader.HasNext()) {
-        switch (col.meta_data.type) {
-          case Type::BOOLEAN: {
-            bool val = reader.GetBool(&is_null, &def_level, &rep_level);
-            ((bool*)(column_ptr[c]))[num_values] = val;
-            break;
-          }
-          case Type::INT32: {
-            int32_t val = reader.GetInt32(&is_null, &def_level, &rep_level);
-            ((int32_t*)(column_ptr[c]))[num_values] = val;
-            break;
-          }
-          case Type::INT64: {
-            int64_t val = reader.GetInt64(&is_null, &def_level, &rep_level);
-            ((int64_t*)(column_ptr[c]))[num_values] = val;
-            break;
-          }
-          case Type::FLOAT: {
-            float val = reader.GetFloat(&is_null, &def_level, &rep_level);
-            ((float*)(column_ptr[c]))[num_values] = val;
-            break;
-          }
-          case Type::DOUBLE: {
-            double val = reader.GetDouble(&is_null, &def_level, &rep_level);
-            ((double*)(column_ptr[c]))[num_values] = val;
-            break;
-          }
-          case Type::BYTE_ARRAY: {
-            ByteArray val = reader.GetByteArray(&is_null, &def_level, &rep_level);
-            ByteArray* dst = &((ByteArray*)(column_ptr[c]))[num_values];
-            if (is_null) {
-              dst->ptr = NULL;
-              dst->len = 0;
-            } else {
-              dst->len = val.len;
-              dst->ptr = new uint8_t[val.len];
-              memcpy((char*)dst->ptr, val.ptr, val.len);
-            }
-            break;
-          }
-
-          default:
-            continue;
-        }
-
-        if (def_level < rep_level) ++num_nulls;
-        ++num_values;
+      switch (col.meta_data.type) {
+        case Type::BOOLEAN:
+          num_values = ReadColumn(static_cast<BoolReader*>(reader.get()),
+              (bool*)column_ptr[c], INIT_SIZE);
+          break;
+        case Type::INT32:
+          num_values = ReadColumn(static_cast<Int32Reader*>(reader.get()),
+              (int32_t*)column_ptr[c], INIT_SIZE);
+          break;
+        case Type::INT64:
+          num_values = ReadColumn(static_cast<Int64Reader*>(reader.get()),
+              (int64_t*)column_ptr[c], INIT_SIZE);
+          break;
+        case Type::FLOAT:
+          num_values = ReadColumn(static_cast<FloatReader*>(reader.get()),
+              (float*)column_ptr[c], INIT_SIZE);
+          break;
+        case Type::DOUBLE:
+          num_values = ReadColumn(static_cast<DoubleReader*>(reader.get()),
+              (double*)column_ptr[c], INIT_SIZE);
+          break;
+        case Type::BYTE_ARRAY:
+          num_values = ReadColumn(static_cast<ByteArrayReader*>(reader.get()),
+              (ByteArray*)column_ptr[c], INIT_SIZE);
+          break;
+        default:
+          break;
       }
 
       total_row_number = num_values;
@@ -289,6 +327,5 @@ void* read_parquet(char* filename) {
     return column_ptr;
   }
 
-  fclose(file);
   return NULL;
 }
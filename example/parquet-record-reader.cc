@@ -12,29 +12,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <parquet/file-reader.h>
 #include <parquet/generic-record.h>
 #include <parquet/parquet.h>
 #include <parquet/schema.h>
 #include <iostream>
 #include <stdio.h>
 
-#include "example_util.h"
-
 using namespace boost;
 using namespace parquet;
 using namespace parquet_cpp;
 using namespace std;
 
 void ReadParquet(char* filename, vector<int> columns) {
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    cerr << "Could not open file: " << filename << endl;
+  shared_ptr<ParquetFileReader> file;
+  try {
+    file = ParquetFileReader::Open(filename);
+  } catch (const ParquetException& e) {
+    cerr << e.what() << endl;
     return;
   }
-
-  FileMetaData metadata;
-  if (!GetFileMetadata(filename, &metadata)) return;
-  shared_ptr<Schema> schema = Schema::FromParquet(metadata.schema);
+  const FileMetaData& metadata = file->metadata();
+  Schema* schema = file->mutable_schema();
 
   if (columns.empty()) {
     for (int i = 0; i < schema->leaves().size(); ++i) {
@@ -56,10 +55,10 @@ void ReadParquet(char* filename, vector<int> columns) {
   for (int i = 0; i < metadata.row_groups.size(); ++i) {
     const RowGroup& row_group = metadata.row_groups[i];
 
+    shared_ptr<RowGroupReader> row_group_reader = file->RowGroup(i);
     vector<InputStream*> streams;
     vector<const Schema::Element*> projected_cols;
     vector<const ColumnMetaData*> col_metadata;
-    vector<uint8_t*> col_buffers;
 
     // Read all the columns we are interested in.
     for (int c = 0; c < columns.size(); ++c) {
@@ -69,28 +68,12 @@ void ReadParquet(char* filename, vector<int> columns) {
         return;
       }
 
-      const ColumnChunk& col = row_group.columns[col_idx];
-      size_t col_start = col.meta_data.data_page_offset;
-      if (col.meta_data.__isset.dictionary_page_offset) {
-        if (col_start > col.meta_data.dictionary_page_offset) {
-          col_start = col.meta_data.dictionary_page_offset;
-        }
-      }
-      fseek(file, col_start, SEEK_SET);
-      col_buffers.push_back(new uint8_t[col.meta_data.total_compressed_size]);
-      size_t num_read = fread(
-          col_buffers[c], 1, col.meta_data.total_compressed_size, file);
-      if (num_read != col.meta_data.total_compressed_size) {
-        cerr << "Could not read column data." << endl;
-        continue;
-      }
-
-      streams.push_back(new InMemoryInputStream(col_buffers[c], num_read));
+      streams.push_back(row_group_reader->ColumnStream(col_idx));
       projected_cols.push_back(schema->leaves()[col_idx]);
-      col_metadata.push_back(&col.meta_data);
+      col_metadata.push_back(&row_group_reader->column_metadata(col_idx));
     }
 
-    RecordReader reader(schema.get(), &metadata, i,
+    RecordReader reader(schema, &metadata, i,
         projected_cols, col_metadata, streams);
     printf("Total rows: %ld\n", reader.rows_left());
 
@@ -100,14 +83,7 @@ void ReadParquet(char* filename, vector<int> columns) {
         printf("%s\n", records[j]->ToString(schema->root()).c_str());
       }
     }
-
-    for (int j = 0; j < streams.size(); ++j) {
-      delete streams[j];
-      delete col_buffers[j];
-    }
   }
-
-  fclose(file);
 }
 
 void PrintUsage() {
@@ -88,15 +88,21 @@ int _kCompressionCodecValues[] = {
   CompressionCodec::UNCOMPRESSED,
   CompressionCodec::SNAPPY,
   CompressionCodec::GZIP,
-  CompressionCodec::LZO
+  CompressionCodec::LZO,
+  CompressionCodec::BROTLI,
+  CompressionCodec::LZ4,
+  CompressionCodec::ZSTD
 };
 const char* _kCompressionCodecNames[] = {
   "UNCOMPRESSED",
   "SNAPPY",
   "GZIP",
-  "LZO"
+  "LZO",
+  "BROTLI",
+  "LZ4",
+  "ZSTD"
 };
-const std::map<int, const char*> _CompressionCodec_VALUES_TO_NAMES(::apache::thrift::TEnumIterator(4, _kCompressionCodecValues, _kCompressionCodecNames), ::apache::thrift::TEnumIterator(-1, NULL, NULL));
+const std::map<int, const char*> _CompressionCodec_VALUES_TO_NAMES(::apache::thrift::TEnumIterator(7, _kCompressionCodecValues, _kCompressionCodecNames), ::apache::thrift::TEnumIterator(-1, NULL, NULL));
 
 int _kPageTypeValues[] = {
   PageType::DATA_PAGE,
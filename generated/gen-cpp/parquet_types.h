@@ -74,7 +74,10 @@ struct CompressionCodec {
     UNCOMPRESSED = 0,
     SNAPPY = 1,
     GZIP = 2,
-    LZO = 3
+    LZO = 3,
+    BROTLI = 4,
+    LZ4 = 5,
+    ZSTD = 6
   };
 };
 
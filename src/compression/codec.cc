@@ -0,0 +1,39 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "codec.h"
+
+using namespace parquet;
+using namespace parquet_cpp;
+
+Codec* Codec::Create(CompressionCodec::type codec) {
+  switch (codec) {
+    case CompressionCodec::UNCOMPRESSED:
+      return NULL;
+    case CompressionCodec::SNAPPY:
+      return new SnappyCodec();
+    case CompressionCodec::LZ4:
+      return new Lz4Codec();
+    case CompressionCodec::GZIP:
+      return new GzipCodec();
+    case CompressionCodec::ZSTD:
+      return new ZstdCodec();
+    case CompressionCodec::LZO:
+    case CompressionCodec::BROTLI:
+      PARQUET_NOT_YET_IMPLEMENTED("Unsupported compression codec.");
+    default:
+      throw ParquetException("Unknown compression codec.");
+  }
+  return NULL;
+}
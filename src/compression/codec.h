@@ -21,10 +21,17 @@
 #include "gen-cpp/parquet_constants.h"
 #include "gen-cpp/parquet_types.h"
 
+// From zlib.h.
+struct z_stream_s;
+
 namespace parquet_cpp {
 
 class Codec {
  public:
+  // Returns a new codec for pages compressed with 'codec', or NULL if they are
+  // UNCOMPRESSED. Throws ParquetException for codecs that are not supported.
+  static Codec* Create(parquet::CompressionCodec::type codec);
+
   virtual ~Codec() {}
   virtual void Decompress(int input_len, const uint8_t* input,
       int output_len, uint8_t* output_buffer) = 0;
@@ -53,6 +60,10 @@ class SnappyCodec : public Codec {
 };
 
 // Lz4 codec.
+// Compress() writes a raw LZ4 block. Decompress() reads both raw blocks and the
+// Hadoop framing that parquet-mr writers emit (blocks prefixed with their big endian
+// decompressed and compressed sizes), but not the LZ4 frame format. Decompression
+// is bounds checked, so corrupt input cannot write past the output buffer.
 class Lz4Codec : public Codec {
  public:
   virtual void Decompress(int input_len, const uint8_t* input,
@@ -66,6 +77,59 @@ class Lz4Codec : public Codec {
   virtual const char* name() const { return "lz4"; }
 };
 
+// gzip (deflate) compression. Decompression also accepts zlib streams. The
+// inflate and deflate state is created on first use and reset for each page, so a
+// codec is cheap to reuse but must not be used by several threads at once.
+class GzipCodec : public Codec {
+ public:
+  GzipCodec();
+  virtual ~GzipCodec();
+
+  virtual void Decompress(int input_len, const uint8_t* input,
+      int output_len, uint8_t* output_buffer);
+
+  virtual int Compress(int input_len, const uint8_t* input,
+      int output_buffer_len, uint8_t* output_buffer);
+
+  virtual int MaxCompressedLen(int input_len, const uint8_t* input);
+
+  virtual const char* name() const { return "gzip"; }
+
+ private:
+  // Creates or resets deflate_stream_.
+  void InitDeflate();
+
+  z_stream_s* inflate_stream_;
+  z_stream_s* deflate_stream_;
+};
+
+// Zstandard codec. Pages are single zstd frames. The zstd contexts are per thread
+// and reused by every ZstdCodec on that thread, so codecs are cheap to create and
+// can be shared between threads. The compression level only affects Compress():
+// higher levels compress better and slower, decompression speed barely changes.
+class ZstdCodec : public Codec {
+ public:
+  static const int DEFAULT_COMPRESSION_LEVEL = 1;
+
+  // Throws ParquetException if 'compression_level' is not a valid zstd level.
+  explicit ZstdCodec(int compression_level = DEFAULT_COMPRESSION_LEVEL);
+
+  virtual void Decompress(int input_len, const uint8_t* input,
+      int output_len, uint8_t* output_buffer);
+
+  virtual int Compress(int input_len, const uint8_t* input,
+      int output_buffer_len, uint8_t* output_buffer);
+
+  virtual int MaxCompressedLen(int input_len, const uint8_t* input);
+
+  virtual const char* name() const { return "zstd"; }
+
+  int compression_level() const { return compression_level_; }
+
+ private:
+  int compression_level_;
+};
+
 }
 
 #endif
@@ -0,0 +1,102 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "codec.h"
+
+#include <string.h>
+#include <zlib.h>
+
+using namespace parquet_cpp;
+
+// Window bits for deflate/inflate: the maximum window, plus 16 to write a gzip
+// header and trailer, or plus 32 to accept either a gzip or a zlib header.
+static const int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+static const int DETECT_WINDOW_BITS = MAX_WBITS + 32;
+
+GzipCodec::GzipCodec() : inflate_stream_(NULL), deflate_stream_(NULL) {
+}
+
+GzipCodec::~GzipCodec() {
+  if (inflate_stream_ != NULL) {
+    inflateEnd(inflate_stream_);
+    delete inflate_stream_;
+  }
+  if (deflate_stream_ != NULL) {
+    deflateEnd(deflate_stream_);
+    delete deflate_stream_;
+  }
+}
+
+void GzipCodec::Decompress(int input_len, const uint8_t* input,
+    int output_len, uint8_t* output_buffer) {
+  // Keep the inflate state (and its window) across pages; resetting it is much
+  // cheaper than setting it up again.
+  if (inflate_stream_ == NULL) {
+    z_stream* stream = new z_stream();
+    memset(stream, 0, sizeof(z_stream));
+    if (inflateInit2(stream, DETECT_WINDOW_BITS) != Z_OK) {
+      delete stream;
+      throw ParquetException("Could not initialize gzip decompression.");
+    }
+    inflate_stream_ = stream;
+  } else if (inflateReset(inflate_stream_) != Z_OK) {
+    throw ParquetException("Could not reset gzip decompression.");
+  }
+
+  // Inflate straight into the output in one call.
+  inflate_stream_->next_in = const_cast<Bytef*>(input);
+  inflate_stream_->avail_in = input_len;
+  inflate_stream_->next_out = output_buffer;
+  inflate_stream_->avail_out = output_len;
+  int ret = inflate(inflate_stream_, Z_FINISH);
+  if (ret != Z_STREAM_END || inflate_stream_->total_out != output_len) {
+    throw ParquetException("Corrupt gzip compressed data.");
+  }
+}
+
+void GzipCodec::InitDeflate() {
+  if (deflate_stream_ != NULL) {
+    if (deflateReset(deflate_stream_) != Z_OK) {
+      throw ParquetException("Could not reset gzip compression.");
+    }
+    return;
+  }
+  z_stream* stream = new z_stream();
+  memset(stream, 0, sizeof(z_stream));
+  if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8,
+      Z_DEFAULT_STRATEGY) != Z_OK) {
+    delete stream;
+    throw ParquetException("Could not initialize gzip compression.");
+  }
+  deflate_stream_ = stream;
+}
+
+int GzipCodec::MaxCompressedLen(int input_len, const uint8_t* input) {
+  // The bound depends on the stream's settings (e.g. the gzip header).
+  InitDeflate();
+  return deflateBound(deflate_stream_, input_len);
+}
+
+int GzipCodec::Compress(int input_len, const uint8_t* input,
+    int output_buffer_len, uint8_t* output_buffer) {
+  InitDeflate();
+  deflate_stream_->next_in = const_cast<Bytef*>(input);
+  deflate_stream_->avail_in = input_len;
+  deflate_stream_->next_out = output_buffer;
+  deflate_stream_->avail_out = output_buffer_len;
+  if (deflate(deflate_stream_, Z_FINISH) != Z_STREAM_END) {
+    throw ParquetException("gzip output buffer too small.");
+  }
+  return deflate_stream_->total_out;
+}
@@ -18,11 +18,47 @@
 
 using namespace parquet_cpp;
 
+static uint32_t ReadBigEndian32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+      (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+// Decompresses pages written by Hadoop's Lz4Codec (parquet-mr and other Hadoop
+// based writers). The data is split into frames of a 4 byte big endian
+// decompressed size, a 4 byte big endian compressed size and a raw LZ4 block of
+// that size. Returns false if 'input' is not framed like that or does not
+// decompress to exactly output_len bytes.
+static bool DecompressHadoopFrames(int input_len, const uint8_t* input,
+    int output_len, uint8_t* output_buffer) {
+  const int FRAME_HEADER_LEN = 2 * sizeof(uint32_t);
+  while (input_len >= FRAME_HEADER_LEN) {
+    uint32_t decompressed_len = ReadBigEndian32(input);
+    uint32_t compressed_len = ReadBigEndian32(input + sizeof(uint32_t));
+    input += FRAME_HEADER_LEN;
+    input_len -= FRAME_HEADER_LEN;
+    if (compressed_len > static_cast<uint32_t>(input_len) ||
+        decompressed_len > static_cast<uint32_t>(output_len)) {
+      return false;
+    }
+    int n = LZ4_uncompress_unknownOutputSize(reinterpret_cast<const char*>(input),
+        reinterpret_cast<char*>(output_buffer), compressed_len, decompressed_len);
+    if (n < 0 || static_cast<uint32_t>(n) != decompressed_len) return false;
+    input += compressed_len;
+    input_len -= compressed_len;
+    output_buffer += n;
+    output_len -= n;
+  }
+  return input_len == 0 && output_len == 0;
+}
+
 void Lz4Codec::Decompress(int input_len, const uint8_t* input,
       int output_len, uint8_t* output_buffer) {
-  int n = LZ4_uncompress(reinterpret_cast<const char*>(input),
-      reinterpret_cast<char*>(output_buffer), output_len);
-  if (n != input_len) {
+  // Raw blocks are very unlikely to also parse as frames that decompress to exactly
+  // output_len bytes, so the framing is tried first.
+  if (DecompressHadoopFrames(input_len, input, output_len, output_buffer)) return;
+  int n = LZ4_uncompress_unknownOutputSize(reinterpret_cast<const char*>(input),
+      reinterpret_cast<char*>(output_buffer), input_len, output_len);
+  if (n != output_len) {
     throw ParquetException("Corrupt lz4 compressed data.");
   }
 }
@@ -33,6 +69,10 @@ int Lz4Codec::MaxCompressedLen(int input_len, const uint8_t* input) {
 
 int Lz4Codec::Compress(int input_len, const uint8_t* input,
     int output_buffer_len, uint8_t* output_buffer) {
-  return LZ4_compress(reinterpret_cast<const char*>(input),
-      reinterpret_cast<char*>(output_buffer), input_len);
+  int n = LZ4_compress_limitedOutput(reinterpret_cast<const char*>(input),
+      reinterpret_cast<char*>(output_buffer), input_len, output_buffer_len);
+  if (n == 0 && input_len > 0) {
+    throw ParquetException("lz4 output buffer too small.");
+  }
+  return n;
 }
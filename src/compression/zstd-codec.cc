@@ -0,0 +1,90 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "codec.h"
+
+#include <string>
+#include <boost/thread/tss.hpp>
+#include <zstd.h>
+
+using namespace boost;
+using namespace parquet_cpp;
+using namespace std;
+
+// The zstd contexts of a thread. Creating a context allocates its tables and
+// window, so they are created on first use and kept for the thread's lifetime.
+class ZstdContexts {
+ public:
+  ZstdContexts() : cctx_(NULL), dctx_(NULL) {}
+
+  ~ZstdContexts() {
+    if (cctx_ != NULL) ZSTD_freeCCtx(cctx_);
+    if (dctx_ != NULL) ZSTD_freeDCtx(dctx_);
+  }
+
+  static ZstdContexts* ThreadLocal() {
+    static thread_specific_ptr<ZstdContexts> contexts;
+    if (contexts.get() == NULL) contexts.reset(new ZstdContexts());
+    return contexts.get();
+  }
+
+  ZSTD_CCtx* cctx() {
+    if (cctx_ == NULL) {
+      cctx_ = ZSTD_createCCtx();
+      if (cctx_ == NULL) throw ParquetException("Could not create zstd context.");
+    }
+    return cctx_;
+  }
+
+  ZSTD_DCtx* dctx() {
+    if (dctx_ == NULL) {
+      dctx_ = ZSTD_createDCtx();
+      if (dctx_ == NULL) throw ParquetException("Could not create zstd context.");
+    }
+    return dctx_;
+  }
+
+ private:
+  ZSTD_CCtx* cctx_;
+  ZSTD_DCtx* dctx_;
+};
+
+ZstdCodec::ZstdCodec(int compression_level) : compression_level_(compression_level) {
+  if (compression_level < 1 || compression_level > ZSTD_maxCLevel()) {
+    throw ParquetException("Invalid zstd compression level.");
+  }
+}
+
+void ZstdCodec::Decompress(int input_len, const uint8_t* input,
+    int output_len, uint8_t* output_buffer) {
+  size_t n = ZSTD_decompressDCtx(ZstdContexts::ThreadLocal()->dctx(),
+      output_buffer, output_len, input, input_len);
+  if (ZSTD_isError(n) || n != output_len) {
+    throw ParquetException("Corrupt zstd compressed data.");
+  }
+}
+
+int ZstdCodec::MaxCompressedLen(int input_len, const uint8_t* input) {
+  return ZSTD_compressBound(input_len);
+}
+
+int ZstdCodec::Compress(int input_len, const uint8_t* input,
+    int output_buffer_len, uint8_t* output_buffer) {
+  size_t n = ZSTD_compressCCtx(ZstdContexts::ThreadLocal()->cctx(),
+      output_buffer, output_buffer_len, input, input_len, compression_level_);
+  if (ZSTD_isError(n)) {
+    throw ParquetException(string("zstd compression failed: ") + ZSTD_getErrorName(n));
+  }
+  return n;
+}
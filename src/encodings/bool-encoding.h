@@ -25,31 +25,40 @@ class BoolDecoder : public Decoder {
 
   virtual void SetData(int num_values, const uint8_t* data, int len) {
     num_values_ = num_values;
-    decoder_ = impala::RleDecoder(data, len, 1);
+    decoder_ = impala::BitReader(data, len);
   }
 
   virtual int Get(bool* buffer, int max_values) {
     max_values = std::min(max_values, num_values_);
     for (int i = 0; i < max_values; ++i) {
-      if (!decoder_.Get(&buffer[i])) ParquetException::EofException();
+      if (!decoder_.GetValue(1, &buffer[i])) ParquetException::EofException();
     }
     num_values_ -= max_values;
     return max_values;
   }
 
+  virtual int Skip(int num_values) {
+    num_values = std::min(num_values, num_values_);
+    if (!decoder_.SkipBits(num_values)) ParquetException::EofException();
+    num_values_ -= num_values;
+    return num_values;
+  }
+
  private:
-  impala::RleDecoder decoder_;
+  // PLAIN encoded booleans are bit packed (LSB first) with no run length encoding.
+  impala::BitReader decoder_;
 };
 
 class BoolEncoder : public Encoder {
  public:
   BoolEncoder(int buffer_size)
     : Encoder(parquet::Type::BOOLEAN, parquet::Encoding::PLAIN, buffer_size),
-      encoder_(buffer_, buffer_size_, 1) {
+      encoder_(buffer_, buffer_size_) {
   }
 
   virtual const uint8_t* Encode(int* encoded_len) {
-    *encoded_len = encoder_.Flush();
+    encoder_.Flush();
+    *encoded_len = encoder_.bytes_written();
     return encoder_.buffer();
   }
 
@@ -60,13 +69,17 @@ class BoolEncoder : public Encoder {
 
   virtual int Add(const bool* values, int num_values) {
     for (int i = 0; i < num_values; ++i) {
-      if (!encoder_.Put(values[i])) return i;
+      if (!encoder_.PutValue(values[i], 1)) {
+        num_values_ += i;
+        return i;
+      }
     }
+    num_values_ += num_values;
     return num_values;
   }
 
  private:
-  impala::RleEncoder encoder_;
+  impala::BitWriter encoder_;
 };
 
 }
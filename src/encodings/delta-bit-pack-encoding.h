@@ -59,8 +59,13 @@ class DeltaBitPackDecoder : public Decoder {
       if (!decoder_.GetAligned<uint8_t>(1, &delta_bit_widths_[i])) {
         ParquetException::EofException();
       }
+      int max_bit_width = type_ == parquet::Type::INT32 ? 32 : 64;
+      if (delta_bit_widths_[i] > max_bit_width) {
+        throw ParquetException("Invalid delta bit width.");
+      }
     }
     values_per_mini_block_ = block_size / num_mini_blocks_;
+    deltas_.resize(values_per_mini_block_);
     mini_block_idx_ = 0;
     delta_bit_width_ = delta_bit_widths_[0];
     values_current_mini_block_ = values_per_mini_block_;
@@ -69,7 +74,8 @@ class DeltaBitPackDecoder : public Decoder {
   template <typename T>
   int GetInternal(T* buffer, int max_values) {
     max_values = std::min(max_values, num_values_);
-    for (int i = 0; i < max_values; ++i) {
+    int i = 0;
+    while (i < max_values) {
       if (UNLIKELY(values_current_mini_block_ == 0)) {
         ++mini_block_idx_;
         if (mini_block_idx_ < delta_bit_widths_.size()) {
@@ -77,18 +83,22 @@ class DeltaBitPackDecoder : public Decoder {
           values_current_mini_block_ = values_per_mini_block_;
         } else {
           InitBlock();
-          buffer[i] = last_value_;
+          buffer[i++] = last_value_;
           continue;
         }
       }
 
-      // TODO: the key to this algorithm is to decode the entire miniblock at once.
-      int64_t delta;
-      if (!decoder_.GetValue(delta_bit_width_, &delta)) ParquetException::EofException();
-      delta += min_delta_;
-      last_value_ += delta;
-      buffer[i] = last_value_;
-      --values_current_mini_block_;
+      // Unpack the deltas of the mini block in one batch.
+      int num_deltas = std::min<uint64_t>(max_values - i, values_current_mini_block_);
+      if (decoder_.GetBatch(delta_bit_width_, &deltas_[0], num_deltas) != num_deltas) {
+        ParquetException::EofException();
+      }
+      for (int j = 0; j < num_deltas; ++j) {
+        last_value_ += deltas_[j] + min_delta_;
+        buffer[i + j] = last_value_;
+      }
+      values_current_mini_block_ -= num_deltas;
+      i += num_deltas;
     }
     num_values_ -= max_values;
     return max_values;
@@ -104,6 +114,7 @@ class DeltaBitPackDecoder : public Decoder {
   int mini_block_idx_;
   std::vector<uint8_t> delta_bit_widths_;
   int delta_bit_width_;
+  std::vector<int64_t> deltas_;
 
   int64_t last_value_;
 };
@@ -19,54 +19,21 @@
 
 namespace parquet_cpp {
 
+// Decoder for dictionary (RLE encoded index) pages of type TYPE.
+template <parquet::Type::type TYPE>
 class DictionaryDecoder : public Decoder {
  public:
+  typedef typename type_traits<TYPE>::value_type T;
+
   // Initializes the dictionary with values from 'dictionary'. The data in dictionary
   // is not guaranteed to persist in memory after this call so the dictionary decoder
   // needs to copy the data out if necessary.
-  DictionaryDecoder(const parquet::Type::type& type, Decoder* dictionary)
-    : Decoder(type, parquet::Encoding::RLE_DICTIONARY) {
+  DictionaryDecoder(Decoder* dictionary)
+    : Decoder(TYPE, parquet::Encoding::RLE_DICTIONARY) {
     int num_dictionary_values = dictionary->values_left();
-    switch (type) {
-      case parquet::Type::BOOLEAN:
-        throw ParquetException("Boolean cols should not be dictionary encoded.");
-
-      case parquet::Type::INT32:
-        int32_dictionary_.resize(num_dictionary_values);
-        dictionary->Get(&int32_dictionary_[0], num_dictionary_values);
-        break;
-      case parquet::Type::INT64:
-        int64_dictionary_.resize(num_dictionary_values);
-        dictionary->Get(&int64_dictionary_[0], num_dictionary_values);
-        break;
-      case parquet::Type::FLOAT:
-        float_dictionary_.resize(num_dictionary_values);
-        dictionary->Get(&float_dictionary_[0], num_dictionary_values);
-        break;
-      case parquet::Type::DOUBLE:
-        double_dictionary_.resize(num_dictionary_values);
-        dictionary->Get(&double_dictionary_[0], num_dictionary_values);
-        break;
-      case parquet::Type::BYTE_ARRAY: {
-        byte_array_dictionary_.resize(num_dictionary_values);
-        dictionary->Get(&byte_array_dictionary_[0], num_dictionary_values);
-        int total_size = 0;
-        for (int i = 0; i < num_dictionary_values; ++i) {
-          total_size += byte_array_dictionary_[i].len;
-        }
-        byte_array_data_.resize(total_size);
-        int offset = 0;
-        for (int i = 0; i < num_dictionary_values; ++i) {
-          memcpy(&byte_array_data_[offset],
-              byte_array_dictionary_[i].ptr, byte_array_dictionary_[i].len);
-          byte_array_dictionary_[i].ptr = &byte_array_data_[offset];
-          offset += byte_array_dictionary_[i].len;
-        }
-        break;
-      }
-      default:
-        PARQUET_NOT_YET_IMPLEMENTED("Unsupported dictionary type");
-    }
+    dictionary_.resize(num_dictionary_values);
+    dictionary->Get(&dictionary_[0], num_dictionary_values);
+    CopyDictionaryData();
   }
 
   virtual void SetData(int num_values, const uint8_t* data, int len) {
@@ -78,68 +45,74 @@ class DictionaryDecoder : public Decoder {
     idx_decoder_ = impala::RleDecoder(data, len, bit_width);
   }
 
-  virtual int Get(int32_t* buffer, int max_values) {
+  virtual int Get(T* buffer, int max_values) {
     max_values = std::min(max_values, num_values_);
-    for (int i = 0; i < max_values; ++i) {
-      buffer[i] = int32_dictionary_[index()];
-    }
+    int decoded = idx_decoder_.GetBatchWithDict(
+        dictionary_.empty() ? NULL : &dictionary_[0], dictionary_.size(), buffer,
+        max_values);
+    if (decoded < 0) throw ParquetException("Dictionary index out of range.");
+    if (decoded != max_values) ParquetException::EofException();
+    num_values_ -= max_values;
     return max_values;
   }
 
-  virtual int Get(int64_t* buffer, int max_values) {
+  // Returns the next 'max_values' dictionary indices without looking them up, for
+  // callers that work on the indices and materialize values from dictionary()
+  // later. Returns the number of indices read.
+  int GetIndices(int32_t* indices, int max_values) {
     max_values = std::min(max_values, num_values_);
-    for (int i = 0; i < max_values; ++i) {
-      buffer[i] = int64_dictionary_[index()];
+    if (idx_decoder_.GetBatch(indices, max_values) != max_values) {
+      ParquetException::EofException();
     }
-    return max_values;
-  }
-
-  virtual int Get(float* buffer, int max_values) {
-    max_values = std::min(max_values, num_values_);
+    uint32_t max_index = 0;
     for (int i = 0; i < max_values; ++i) {
-      buffer[i] = float_dictionary_[index()];
+      max_index = std::max(max_index, static_cast<uint32_t>(indices[i]));
     }
-    return max_values;
-  }
-
-  virtual int Get(double* buffer, int max_values) {
-    max_values = std::min(max_values, num_values_);
-    for (int i = 0; i < max_values; ++i) {
-      buffer[i] = double_dictionary_[index()];
+    if (max_values > 0 && max_index >= dictionary_.size()) {
+      throw ParquetException("Dictionary index out of range.");
     }
+    num_values_ -= max_values;
     return max_values;
   }
 
-  virtual int Get(ByteArray* buffer, int max_values) {
-    max_values = std::min(max_values, num_values_);
-    for (int i = 0; i < max_values; ++i) {
-      buffer[i] = byte_array_dictionary_[index()];
-    }
-    return max_values;
+  // The decoded dictionary values, which stay valid for the life of the decoder.
+  const std::vector<T>& dictionary() const { return dictionary_; }
+
+  virtual int Skip(int num_values) {
+    num_values = std::min(num_values, num_values_);
+    if (idx_decoder_.Skip(num_values) != num_values) ParquetException::EofException();
+    num_values_ -= num_values;
+    return num_values;
   }
 
  private:
-  int index() {
-    int idx = 0;
-    if (!idx_decoder_.Get(&idx)) ParquetException::EofException();
-    --num_values_;
-    return idx;
-  }
+  // Makes the dictionary own the data its values point to. Only byte arrays point
+  // into the (transient) dictionary page.
+  void CopyDictionaryData() {}
 
-  // Only one is set.
-  std::vector<int32_t> int32_dictionary_;
-  std::vector<int64_t> int64_dictionary_;
-  std::vector<float> float_dictionary_;
-  std::vector<double> double_dictionary_;
-  std::vector<ByteArray> byte_array_dictionary_;
+  std::vector<T> dictionary_;
 
-  // Data that contains the byte array data (byte_array_dictionary_ just has the
-  // pointers).
+  // Data that contains the byte array data (dictionary_ just has the pointers).
   std::vector<uint8_t> byte_array_data_;
 
   impala::RleDecoder idx_decoder_;
 };
 
+template <>
+inline void DictionaryDecoder<parquet::Type::BYTE_ARRAY>::CopyDictionaryData() {
+  int total_size = 0;
+  for (int i = 0; i < dictionary_.size(); ++i) {
+    total_size += dictionary_[i].len;
+  }
+  byte_array_data_.resize(total_size);
+  int offset = 0;
+  for (int i = 0; i < dictionary_.size(); ++i) {
+    memcpy(&byte_array_data_[offset], dictionary_[i].ptr, dictionary_[i].len);
+    dictionary_[i].ptr = &byte_array_data_[offset];
+    offset += dictionary_[i].len;
+  }
+}
+
 }
 
 #endif
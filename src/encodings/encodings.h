@@ -56,6 +56,13 @@ class Decoder {
     throw ParquetException("Decoder does not implement this type.");
   }
 
+  // Skips the next 'num_values' values without decoding them if the encoding allows
+  // it. Returns the number of values skipped, which should be num_values except for
+  // end of the current data page.
+  virtual int Skip(int num_values) {
+    throw ParquetException("Decoder does not implement Skip().");
+  }
+
   // Returns the number of values left (for the last call to SetData()). This is
   // the number of values left in this page.
   int values_left() const { return num_values_; }
@@ -19,10 +19,15 @@
 
 namespace parquet_cpp {
 
+// Decoder for PLAIN encoded values of type TYPE. Booleans are bit packed and are
+// decoded by BoolDecoder instead.
+template <parquet::Type::type TYPE>
 class PlainDecoder : public Decoder {
  public:
-  PlainDecoder(const parquet::Type::type& type)
-    : Decoder(type, parquet::Encoding::PLAIN), data_(NULL), len_(0) {
+  typedef typename type_traits<TYPE>::value_type T;
+
+  PlainDecoder()
+    : Decoder(TYPE, parquet::Encoding::PLAIN), data_(NULL), len_(0) {
   }
 
   virtual void SetData(int num_values, const uint8_t* data, int len) {
@@ -31,52 +36,92 @@ class PlainDecoder : public Decoder {
     len_ = len;
   }
 
-  virtual int Get(int32_t* buffer, int max_values) {
-    return GetValues(buffer, max_values, sizeof(int32_t));
-  }
-  virtual int Get(int64_t* buffer, int max_values) {
-    return GetValues(buffer, max_values, sizeof(int64_t));
-  }
-  virtual int Get(float* buffer, int max_values) {
-    return GetValues(buffer, max_values, sizeof(float));
-  }
-  virtual int Get(double* buffer, int max_values) {
-    return GetValues(buffer, max_values, sizeof(double));
-  }
-  virtual int Get(ByteArray* buffer, int max_values) {
-    max_values = std::min(max_values, num_values_);
-    int i = 0;
-    for (; i < max_values; ++i) {
-      if (len_ == 0) break;
-      buffer[i].len = *reinterpret_cast<const uint32_t*>(data_);
-      if (len_ < sizeof(uint32_t) + buffer[i].len) ParquetException::EofException();
-      buffer[i].ptr = data_ + sizeof(uint32_t);
-      data_ += sizeof(uint32_t) + buffer[i].len;
-      len_ -= sizeof(uint32_t) + buffer[i].len;
-    }
-    num_values_ -= i;
-    return i;
-  }
+  virtual int Get(T* buffer, int max_values);
+  virtual int Skip(int num_values);
+
+  // Returns a pointer to the next 'num_values' values directly in the page data and
+  // advances past them, instead of copying them out like Get(). Returns NULL, without
+  // advancing, if the page does not have that many values left or the data is not
+  // aligned for T. The result points into the buffer passed to SetData().
+  // Only valid for fixed width types.
+  const T* GetInPlace(int num_values);
 
  private:
   const uint8_t* data_;
   int len_;
-
-  int GetValues(void* buffer, int max_values, int byte_size) {
-    max_values = std::min(max_values, num_values_);
-    int size = max_values * byte_size;
-    if (len_ < size) {
-      max_values = len_ / byte_size;
-      size = max_values * byte_size;
-    }
-    memcpy(buffer, data_, size);
-    data_ += size;
-    len_ -= size;
-    num_values_ -= max_values;
-    return max_values;
-  }
 };
 
+template <parquet::Type::type TYPE>
+inline int PlainDecoder<TYPE>::Get(T* buffer, int max_values) {
+  max_values = std::min(max_values, num_values_);
+  int size = max_values * sizeof(T);
+  if (len_ < size) {
+    max_values = len_ / sizeof(T);
+    size = max_values * sizeof(T);
+  }
+  memcpy(buffer, data_, size);
+  data_ += size;
+  len_ -= size;
+  num_values_ -= max_values;
+  return max_values;
+}
+
+template <parquet::Type::type TYPE>
+inline int PlainDecoder<TYPE>::Skip(int num_values) {
+  num_values = std::min(num_values, num_values_);
+  num_values = std::min<int>(num_values, len_ / sizeof(T));
+  data_ += num_values * sizeof(T);
+  len_ -= num_values * sizeof(T);
+  num_values_ -= num_values;
+  return num_values;
+}
+
+template <parquet::Type::type TYPE>
+inline const typename PlainDecoder<TYPE>::T* PlainDecoder<TYPE>::GetInPlace(
+    int num_values) {
+  int size = num_values * sizeof(T);
+  if (num_values > num_values_ || size > len_) return NULL;
+  if (reinterpret_cast<uintptr_t>(data_) % __alignof__(T) != 0) return NULL;
+  const T* result = reinterpret_cast<const T*>(data_);
+  data_ += size;
+  len_ -= size;
+  num_values_ -= num_values;
+  return result;
+}
+
+template <>
+inline int PlainDecoder<parquet::Type::BYTE_ARRAY>::Get(ByteArray* buffer,
+    int max_values) {
+  max_values = std::min(max_values, num_values_);
+  int i = 0;
+  for (; i < max_values; ++i) {
+    if (len_ == 0) break;
+    buffer[i].len = *reinterpret_cast<const uint32_t*>(data_);
+    if (len_ < sizeof(uint32_t) + buffer[i].len) ParquetException::EofException();
+    buffer[i].ptr = data_ + sizeof(uint32_t);
+    data_ += sizeof(uint32_t) + buffer[i].len;
+    len_ -= sizeof(uint32_t) + buffer[i].len;
+  }
+  num_values_ -= i;
+  return i;
+}
+
+template <>
+inline int PlainDecoder<parquet::Type::BYTE_ARRAY>::Skip(int num_values) {
+  // The values are length prefixed so only the lengths need to be read.
+  num_values = std::min(num_values, num_values_);
+  int i = 0;
+  for (; i < num_values; ++i) {
+    if (len_ == 0) break;
+    uint32_t len = *reinterpret_cast<const uint32_t*>(data_);
+    if (len_ < sizeof(uint32_t) + len) ParquetException::EofException();
+    data_ += sizeof(uint32_t) + len;
+    len_ -= sizeof(uint32_t) + len;
+  }
+  num_values_ -= i;
+  return i;
+}
+
 class PlainEncoder : public Encoder {
  public:
   PlainEncoder(const parquet::Type::type& type, int buffer_size)
@@ -0,0 +1,319 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/file-reader.h"
+
+#include <string.h>
+#include <algorithm>
+
+using namespace boost;
+using namespace parquet;
+using namespace std;
+
+namespace parquet_cpp {
+
+// 4 byte constant + 4 byte metadata len
+static const uint32_t FOOTER_SIZE = 8;
+static const uint8_t PARQUET_MAGIC[4] = {'P', 'A', 'R', '1'};
+
+RowGroupReader::RowGroupReader(ParquetFileReader* file, int row_group_idx)
+  : file_(file),
+    row_group_idx_(row_group_idx),
+    row_group_(NULL) {
+  const LazyFileMetaData* lazy_metadata = file->lazy_metadata();
+  if (lazy_metadata != NULL) {
+    num_columns_ = lazy_metadata->num_columns(row_group_idx);
+    num_rows_ = lazy_metadata->num_rows(row_group_idx);
+    lazy_columns_.resize(num_columns_);
+  } else {
+    row_group_ = &file->metadata().row_groups[row_group_idx];
+    num_columns_ = row_group_->columns.size();
+    num_rows_ = row_group_->num_rows;
+  }
+}
+
+const ColumnMetaData& RowGroupReader::column_metadata(int i) const {
+  if (i < 0 || i >= num_columns()) throw ParquetException("Invalid column index.");
+  if (row_group_ != NULL) return row_group_->columns[i].meta_data;
+  if (lazy_columns_[i].get() == NULL) {
+    shared_ptr<ColumnChunk> chunk(new ColumnChunk());
+    file_->lazy_metadata()->GetColumnChunk(row_group_idx_, i, chunk.get());
+    lazy_columns_[i] = chunk;
+  }
+  return lazy_columns_[i]->meta_data;
+}
+
+// Returns the byte range of column chunk 'col' in 'source'. Throws if it is not in
+// the file.
+static void ColumnChunkRange(const ColumnMetaData& col, RandomAccessSource* source,
+    int64_t* col_start, int64_t* col_len) {
+  // The chunk starts with the dictionary page, if there is one.
+  *col_start = col.data_page_offset;
+  if (col.__isset.dictionary_page_offset && col.dictionary_page_offset < *col_start) {
+    *col_start = col.dictionary_page_offset;
+  }
+  *col_len = col.total_compressed_size;
+  if (*col_start < 0 || *col_len < 0 || *col_start + *col_len > source->Size()) {
+    throw ParquetException("Invalid column chunk offsets.");
+  }
+}
+
+InputStream* RowGroupReader::ColumnStream(int i) {
+  const ColumnMetaData& col = column_metadata(i);
+  RandomAccessSource* source = file_->source();
+  int64_t col_start;
+  int64_t col_len;
+  ColumnChunkRange(col, source, &col_start, &col_len);
+
+  shared_ptr<ColumnChunkData> data(new ColumnChunkData());
+  // Use the bytes in place if they were loaded or the source has them in memory
+  // (e.g. a mapped file); uncompressed pages are then never copied.
+  const uint8_t* buffer = NULL;
+  map<int, const uint8_t*>::const_iterator loaded = loaded_columns_.find(i);
+  if (loaded != loaded_columns_.end()) {
+    buffer = loaded->second;
+  } else {
+    source->WillNeed(col_start, col_len);
+    buffer = source->GetRange(col_start, col_len);
+  }
+  if (buffer != NULL) {
+    data->stream.reset(new InMemoryInputStream(buffer, col_len));
+  } else if (file_->read_ahead_bytes() > 0) {
+    int block_size = ::min<int64_t>(PrefetchingInputStream::DEFAULT_BLOCK_SIZE,
+        file_->read_ahead_bytes());
+    data->stream.reset(new PrefetchingInputStream(source, col_start, col_len,
+        block_size, file_->read_ahead_bytes()));
+  } else if (file_->stream_buffer_size() > 0) {
+    data->stream.reset(new BufferedInputStream(source, col_start, col_len,
+        file_->stream_buffer_size()));
+  } else {
+    data->buffer.resize(col_len);
+    uint8_t* read_buffer = data->buffer.empty() ? NULL : &data->buffer[0];
+    if (source->ReadAt(col_start, col_len, read_buffer) != col_len) {
+      ParquetException::EofException();
+    }
+    data->stream.reset(new InMemoryInputStream(read_buffer, col_len));
+  }
+  column_data_.push_back(data);
+  return data->stream.get();
+}
+
+void RowGroupReader::LoadColumns(const vector<int>& columns, int64_t max_hole_size) {
+  LoadColumns(vector<RowGroupReader*>(1, this), columns, max_hole_size);
+}
+
+void RowGroupReader::LoadColumns(const vector<RowGroupReader*>& row_groups,
+    const vector<int>& columns, int64_t max_hole_size) {
+  if (row_groups.empty()) return;
+  RandomAccessSource* source = row_groups[0]->file_->source();
+  // The chunks to load, the row group and column of each.
+  vector<ReadRange> ranges;
+  vector<RowGroupReader*> range_row_groups;
+  vector<int> range_columns;
+  for (int i = 0; i < row_groups.size(); ++i) {
+    for (int j = 0; j < columns.size(); ++j) {
+      int64_t col_start;
+      int64_t col_len;
+      ColumnChunkRange(row_groups[i]->column_metadata(columns[j]), source, &col_start,
+          &col_len);
+      if (source->GetRange(col_start, col_len) != NULL) continue;
+      ranges.push_back(ReadRange(col_start, col_len));
+      range_row_groups.push_back(row_groups[i]);
+      range_columns.push_back(columns[j]);
+    }
+  }
+
+  vector<ReadRange> reads = CoalesceReadRanges(ranges, max_hole_size);
+  vector<shared_ptr<vector<uint8_t> > > buffers;
+  vector<uint8_t*> read_buffers;
+  for (int i = 0; i < reads.size(); ++i) {
+    buffers.push_back(shared_ptr<vector<uint8_t> >(
+        new vector<uint8_t>(reads[i].length)));
+    read_buffers.push_back(buffers.back()->empty() ? NULL : &(*buffers.back())[0]);
+  }
+  source->ReadRanges(reads, read_buffers);
+
+  // Slice the chunks out of the reads that cover them.
+  for (int i = 0; i < reads.size(); ++i) {
+    const ReadRange& read = reads[i];
+    for (int j = 0; j < ranges.size(); ++j) {
+      if (ranges[j].offset < read.offset ||
+          ranges[j].offset + ranges[j].length > read.offset + read.length) {
+        continue;
+      }
+      RowGroupReader* row_group = range_row_groups[j];
+      if (row_group->loaded_buffers_.empty() ||
+          row_group->loaded_buffers_.back() != buffers[i]) {
+        row_group->loaded_buffers_.push_back(buffers[i]);
+      }
+      row_group->loaded_columns_[range_columns[j]] =
+          read_buffers[i] + (ranges[j].offset - read.offset);
+    }
+  }
+}
+
+shared_ptr<ColumnReader> RowGroupReader::Column(int i,
+    const ColumnReader::Config& config) {
+  InputStream* stream = ColumnStream(i);
+  return ColumnReader::Make(&column_metadata(i), file_->schema()->leaves()[i], stream,
+      config);
+}
+
+shared_ptr<ParquetFileReader> ParquetFileReader::Open(const string& path,
+    IoMode io_mode, MetadataCache* cache) {
+  shared_ptr<RandomAccessSource> source;
+  int64_t modification_time = 0;
+  switch (io_mode) {
+    case PREAD: {
+      LocalFileSource* file_source = new LocalFileSource(path);
+      source.reset(file_source);
+      modification_time = file_source->modification_time();
+      break;
+    }
+    case MMAP: {
+      MemoryMappedSource* mapped_source = new MemoryMappedSource(path);
+      source.reset(mapped_source);
+      modification_time = mapped_source->modification_time();
+      break;
+    }
+    case IO_URING: {
+      IoUringSource* uring_source = new IoUringSource(path);
+      source.reset(uring_source);
+      modification_time = uring_source->modification_time();
+      break;
+    }
+  }
+  if (cache == NULL) {
+    return shared_ptr<ParquetFileReader>(new ParquetFileReader(source));
+  }
+
+  shared_ptr<const FileMetaData> metadata;
+  shared_ptr<const Schema> schema;
+  if (cache->Lookup(path, source->Size(), modification_time, &metadata, &schema)) {
+    return shared_ptr<ParquetFileReader>(
+        new ParquetFileReader(source, metadata, schema));
+  }
+  shared_ptr<ParquetFileReader> file(new ParquetFileReader(source));
+  cache->Insert(path, source->Size(), modification_time, file->shared_metadata(),
+      file->shared_schema());
+  return file;
+}
+
+ParquetFileReader::ParquetFileReader(shared_ptr<RandomAccessSource> source,
+    int64_t footer_read_size, bool lazy_footer)
+  : source_(source), read_ahead_bytes_(0), stream_buffer_size_(0) {
+  ReadFooter(footer_read_size, lazy_footer);
+  schema_ = Schema::FromParquet(metadata_->schema);
+}
+
+ParquetFileReader::ParquetFileReader(shared_ptr<RandomAccessSource> source,
+    const shared_ptr<const FileMetaData>& metadata,
+    const shared_ptr<const Schema>& schema)
+  : source_(source), metadata_(metadata), schema_(schema), read_ahead_bytes_(0),
+    stream_buffer_size_(0) {
+}
+
+Schema* ParquetFileReader::mutable_schema() {
+  if (mutable_schema_.get() == NULL) {
+    mutable_schema_ = Schema::FromParquet(metadata_->schema);
+  }
+  return mutable_schema_.get();
+}
+
+shared_ptr<RowGroupReader> ParquetFileReader::RowGroup(int i) {
+  if (i < 0 || i >= num_row_groups()) throw ParquetException("Invalid row group index.");
+  return shared_ptr<RowGroupReader>(new RowGroupReader(this, i));
+}
+
+void ParquetFileReader::WillReadRowGroups(const vector<int>& row_groups) {
+  const Schema* schema =
+      mutable_schema_.get() != NULL ? mutable_schema_.get() : schema_.get();
+  const vector<Schema::Element*>& leaves = schema->leaves();
+  const vector<Schema::Element*>& projected = schema->projected_leaves();
+  for (int i = 0; i < row_groups.size(); ++i) {
+    if (row_groups[i] < 0 || row_groups[i] >= num_row_groups()) {
+      throw ParquetException("Invalid row group index.");
+    }
+    shared_ptr<RowGroupReader> row_group = RowGroup(row_groups[i]);
+    for (int j = 0; j < row_group->num_columns() && j < leaves.size(); ++j) {
+      if (find(projected.begin(), projected.end(), leaves[j]) == projected.end()) {
+        continue;
+      }
+      int64_t col_start;
+      int64_t col_len;
+      ColumnChunkRange(row_group->column_metadata(j), source_.get(), &col_start,
+          &col_len);
+      source_->WillNeed(col_start, col_len);
+    }
+  }
+}
+
+void ParquetFileReader::ReadFooter(int64_t footer_read_size, bool lazy_footer) {
+  int64_t file_len = source_->Size();
+  if (file_len < FOOTER_SIZE) {
+    throw ParquetException("Invalid parquet file. Corrupt footer.");
+  }
+
+  // Read the end of the file speculatively, so footers that fit in it take a
+  // single read. Sources that have the file in memory are read in place.
+  int64_t tail_len = ::min(file_len, ::max<int64_t>(footer_read_size, FOOTER_SIZE));
+  vector<uint8_t> tail_buffer;
+  const uint8_t* tail = source_->GetRange(file_len - tail_len, tail_len);
+  if (tail == NULL) {
+    tail_buffer.resize(tail_len);
+    if (source_->ReadAt(file_len - tail_len, tail_len, &tail_buffer[0]) != tail_len) {
+      throw ParquetException("Invalid parquet file. Corrupt footer.");
+    }
+    tail = &tail_buffer[0];
+  }
+  const uint8_t* footer = tail + tail_len - FOOTER_SIZE;
+  if (memcmp(footer + 4, PARQUET_MAGIC, 4) != 0) {
+    throw ParquetException("Invalid parquet file. Corrupt footer.");
+  }
+
+  uint32_t metadata_len = *reinterpret_cast<const uint32_t*>(footer);
+  int64_t metadata_start = file_len - FOOTER_SIZE - metadata_len;
+  if (metadata_start < 0) {
+    throw ParquetException(
+        "Invalid parquet file. File is less than file metadata size.");
+  }
+  if (metadata_len == 0) {
+    throw ParquetException("Invalid parquet file. Could not read metadata bytes.");
+  }
+
+  const uint8_t* metadata = NULL;
+  vector<uint8_t> metadata_buffer;
+  if (FOOTER_SIZE + metadata_len <= tail_len) {
+    metadata = footer - metadata_len;
+  } else {
+    // The speculative read was too short: read the metadata.
+    metadata_buffer.resize(metadata_len);
+    if (source_->ReadAt(metadata_start, metadata_len, &metadata_buffer[0]) !=
+        metadata_len) {
+      throw ParquetException("Invalid parquet file. Could not read metadata bytes.");
+    }
+    metadata = &metadata_buffer[0];
+  }
+  if (lazy_footer) {
+    lazy_metadata_.reset(new LazyFileMetaData(metadata, metadata_len));
+    metadata_ = shared_ptr<const FileMetaData>(lazy_metadata_,
+        &lazy_metadata_->file_metadata());
+    return;
+  }
+  shared_ptr<FileMetaData> file_metadata(new FileMetaData());
+  DeserializeThriftMsg(metadata, &metadata_len, file_metadata.get());
+  metadata_ = file_metadata;
+}
+
+}
@@ -94,7 +94,7 @@ RecordReader::RecordReader(
   readers_.resize(projected_columns.size());
   for (int i = 0; i < projected_columns.size(); ++i) {
     readers_[i].reader =
-        new ColumnReader(col_metadata[i], projected_columns[i], streams[i]);
+        ColumnReader::Make(col_metadata[i], projected_columns[i], streams[i]);
     readers_[i].schema = schema_->projected_leaves()[i];
   }
   // TODO: verify schema, handle schema resolution.
@@ -105,56 +105,97 @@ RecordReader::RecordReader(
   }
 }
 
-RecordReader::~RecordReader() {
-  for (int i = 0; i < readers_.size(); ++i) {
-    delete readers_[i].reader;
+// Number of levels/values each column reads at a time.
+static const int BATCH_SIZE = 128;
+
+// Reads the next batch from 'reader', which must be a ReaderType, into the untyped
+// 'values' buffer.
+template <typename ReaderType>
+static int ReadTypedBatch(ColumnReader* reader, int16_t* def_levels,
+    int16_t* rep_levels, vector<uint8_t>* values) {
+  typedef typename ReaderType::T T;
+  values->resize(BATCH_SIZE * sizeof(T));
+  int64_t values_read = 0;
+  return static_cast<ReaderType*>(reader)->ReadBatch(BATCH_SIZE, def_levels,
+      rep_levels, reinterpret_cast<T*>(&(*values)[0]), &values_read);
+}
+
+void RecordReader::ColumnState::ReadBatch() {
+  def_levels.resize(BATCH_SIZE);
+  rep_levels.resize(BATCH_SIZE);
+  switch (reader->type()) {
+    case Type::BOOLEAN:
+      num_levels = ReadTypedBatch<BoolReader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    case Type::INT32:
+      num_levels = ReadTypedBatch<Int32Reader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    case Type::INT64:
+      num_levels = ReadTypedBatch<Int64Reader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    case Type::FLOAT:
+      num_levels = ReadTypedBatch<FloatReader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    case Type::DOUBLE:
+      num_levels = ReadTypedBatch<DoubleReader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    case Type::BYTE_ARRAY:
+      num_levels = ReadTypedBatch<ByteArrayReader>(
+          reader.get(), &def_levels[0], &rep_levels[0], &values);
+      break;
+    default:
+      PARQUET_NOT_YET_IMPLEMENTED("Unsupported type");
   }
+  level_idx = 0;
+  value_idx = 0;
 }
 
 void RecordReader::ColumnState::ReadNext() {
-  if (UNLIKELY(!reader->HasNext())) {
-    // When we are done with the column, set rep_level to 0. This indicates a new
-    // record/end of previous record.
-    rep_level = 0;
-    return;
+  if (level_idx == num_levels) {
+    if (UNLIKELY(!reader->HasNext())) {
+      // When we are done with the column, set rep_level to 0. This indicates a new
+      // record/end of previous record.
+      rep_level = 0;
+      return;
+    }
+    ReadBatch();
   }
 
+  def_level = reader->max_def_level() == 0 ? 0 : def_levels[level_idx];
+  rep_level = reader->max_rep_level() == 0 ? 0 : rep_levels[level_idx];
+  ++level_idx;
+
   datum.reset();
-  bool is_null;
+  if (def_level != reader->max_def_level()) return;
   switch (reader->type()) {
-    case Type::BOOLEAN: {
-      bool v = reader->GetBool(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = BoolDatum::Create(v);
+    case Type::BOOLEAN:
+      datum = BoolDatum::Create(reinterpret_cast<bool*>(&values[0])[value_idx]);
       break;
-    }
-    case Type::INT32: {
-      int32_t v = reader->GetInt32(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = Int32Datum::Create(v);
+    case Type::INT32:
+      datum = Int32Datum::Create(reinterpret_cast<int32_t*>(&values[0])[value_idx]);
       break;
-    }
-    case Type::INT64: {
-      int64_t v = reader->GetInt64(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = Int64Datum::Create(v);
+    case Type::INT64:
+      datum = Int64Datum::Create(reinterpret_cast<int64_t*>(&values[0])[value_idx]);
       break;
-    }
-    case Type::FLOAT: {
-      float v = reader->GetFloat(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = FloatDatum::Create(v);
+    case Type::FLOAT:
+      datum = FloatDatum::Create(reinterpret_cast<float*>(&values[0])[value_idx]);
       break;
-    }
-    case Type::DOUBLE: {
-      double v = reader->GetDouble(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = DoubleDatum::Create(v);
+    case Type::DOUBLE:
+      datum = DoubleDatum::Create(reinterpret_cast<double*>(&values[0])[value_idx]);
       break;
-    }
-    case Type::BYTE_ARRAY: {
-      ByteArray v = reader->GetByteArray(&is_null, &def_level, &rep_level);
-      if (!is_null) datum = ByteArrayDatum::Create(v);
+    case Type::BYTE_ARRAY:
+      datum = ByteArrayDatum::Create(
+          reinterpret_cast<ByteArray*>(&values[0])[value_idx]);
       break;
-    }
     default:
       PARQUET_NOT_YET_IMPLEMENTED("Unsupported type");
   }
+  ++value_idx;
 }
 
 vector<shared_ptr<GenericStruct> > RecordReader::GetNext() {
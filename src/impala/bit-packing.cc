@@ -0,0 +1,196 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "impala/bit-packing.h"
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "impala/compiler-util.h"
+#include "impala/cpu-info.h"
+#include "impala/logging.h"
+
+namespace impala {
+
+// Widest values the SIMD kernels handle: a value starting at bit offset 7 must fit in
+// the 32 bit lane it is shuffled into. Wider values (26 to 32 bits) deliberately fall
+// back to the scalar kernels; they would need a value split across two lanes, and
+// dictionary indices and levels, the common bit packed data, are much narrower.
+static const int MAX_SIMD_BITS = 25;
+
+typedef const uint8_t* (*UnpackFn)(const uint8_t* in, uint32_t* out, int num_bits);
+
+template<int NUM_BITS>
+static void UnpackScalar(const uint8_t* in, uint32_t* out) {
+  // The 32 values take exactly NUM_BITS words. The loop has constant bounds and, with
+  // NUM_BITS known, constant shifts, so the compiler unrolls it completely.
+  uint32_t words[NUM_BITS];
+  memcpy(words, in, sizeof(words));
+  const uint32_t mask = static_cast<uint32_t>((1ULL << NUM_BITS) - 1);
+  for (int i = 0; i < 32; ++i) {
+    const int word = i * NUM_BITS / 32;
+    const int offset = i * NUM_BITS % 32;
+    uint32_t value = words[word] >> offset;
+    if (offset + NUM_BITS > 32) value |= words[word + 1] << (32 - offset);
+    out[i] = value & mask;
+  }
+}
+
+template<>
+void UnpackScalar<0>(const uint8_t* in, uint32_t* out) {
+  memset(out, 0, 32 * sizeof(uint32_t));
+}
+
+template<>
+void UnpackScalar<32>(const uint8_t* in, uint32_t* out) {
+  memcpy(out, in, 32 * sizeof(uint32_t));
+}
+
+typedef void (*ScalarKernel)(const uint8_t* in, uint32_t* out);
+
+static const ScalarKernel SCALAR_KERNELS[] = {
+  UnpackScalar<0>, UnpackScalar<1>, UnpackScalar<2>, UnpackScalar<3>,
+  UnpackScalar<4>, UnpackScalar<5>, UnpackScalar<6>, UnpackScalar<7>,
+  UnpackScalar<8>, UnpackScalar<9>, UnpackScalar<10>, UnpackScalar<11>,
+  UnpackScalar<12>, UnpackScalar<13>, UnpackScalar<14>, UnpackScalar<15>,
+  UnpackScalar<16>, UnpackScalar<17>, UnpackScalar<18>, UnpackScalar<19>,
+  UnpackScalar<20>, UnpackScalar<21>, UnpackScalar<22>, UnpackScalar<23>,
+  UnpackScalar<24>, UnpackScalar<25>, UnpackScalar<26>, UnpackScalar<27>,
+  UnpackScalar<28>, UnpackScalar<29>, UnpackScalar<30>, UnpackScalar<31>,
+  UnpackScalar<32>,
+};
+
+// Shuffle masks and shift amounts for the SIMD kernels. Every 8 values start on a byte
+// boundary, so for each bit width there are two patterns: one for the first 4 values
+// of a block of 8 and one for the last 4. Lane i of a pattern receives the 4 bytes
+// starting at the byte holding the first bit of its value.
+struct SimdTables {
+  // Byte offset of each group of 4 values from the start of its block of 8.
+  int group_offset[MAX_SIMD_BITS + 1][2];
+  uint8_t shuffle[MAX_SIMD_BITS + 1][2][16];
+  // Bit offset of each value within its lane (AVX2 variable shifts).
+  uint32_t shift[MAX_SIMD_BITS + 1][2][4];
+  // Power of two that moves the top bit of each value to bit 31 (SSE has no variable
+  // shifts, so the values are aligned with a multiply and then a constant shift).
+  uint32_t multiplier[MAX_SIMD_BITS + 1][2][4];
+
+  SimdTables() {
+    memset(this, 0, sizeof(*this));
+    for (int num_bits = 1; num_bits <= MAX_SIMD_BITS; ++num_bits) {
+      for (int group = 0; group < 2; ++group) {
+        group_offset[num_bits][group] = group * 4 * num_bits / 8;
+        for (int i = 0; i < 4; ++i) {
+          int bit = (group * 4 + i) * num_bits;
+          int byte = bit / 8 - group_offset[num_bits][group];
+          for (int j = 0; j < 4; ++j) {
+            shuffle[num_bits][group][i * 4 + j] = byte + j;
+          }
+          shift[num_bits][group][i] = bit % 8;
+          multiplier[num_bits][group][i] = 1U << (32 - bit % 8 - num_bits);
+        }
+      }
+    }
+  }
+};
+
+static const SimdTables simd_tables;
+
+// Returns a pointer to 16 readable bytes at 'offset' in the group. Loads that would
+// run past the group's 'num_bytes' read from 'padded' instead, which is filled on
+// first use.
+static inline const uint8_t* LoadAddress(const uint8_t* in, int num_bytes, int offset,
+    uint8_t* padded, bool* padded_init) {
+  if (LIKELY(offset + 16 <= num_bytes)) return in + offset;
+  if (!*padded_init) {
+    memcpy(padded, in, num_bytes);
+    memset(padded + num_bytes, 0, 16);
+    *padded_init = true;
+  }
+  return padded + offset;
+}
+
+const uint8_t* BitPacking::Unpack32Scalar(const uint8_t* in, uint32_t* out,
+    int num_bits) {
+  DCHECK_GE(num_bits, 0);
+  DCHECK_LE(num_bits, 32);
+  SCALAR_KERNELS[num_bits](in, out);
+  return in + 4 * num_bits;
+}
+
+const uint8_t* BitPacking::Unpack32Sse(const uint8_t* in, uint32_t* out,
+    int num_bits) {
+  if (num_bits == 0 || num_bits > MAX_SIMD_BITS) {
+    return Unpack32Scalar(in, out, num_bits);
+  }
+  const int num_bytes = 4 * num_bits;
+  uint8_t padded[4 * MAX_SIMD_BITS + 16];
+  bool padded_init = false;
+
+  const __m128i shift = _mm_cvtsi32_si128(32 - num_bits);
+  for (int group = 0; group < 8; ++group) {
+    int pattern = group % 2;
+    int offset = group / 2 * num_bits + simd_tables.group_offset[num_bits][pattern];
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        LoadAddress(in, num_bytes, offset, padded, &padded_init)));
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        simd_tables.shuffle[num_bits][pattern])));
+    v = _mm_mullo_epi32(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        simd_tables.multiplier[num_bits][pattern])));
+    v = _mm_srl_epi32(v, shift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + group * 4), v);
+  }
+  return in + num_bytes;
+}
+
+__attribute__((target("avx2")))
+const uint8_t* BitPacking::Unpack32Avx2(const uint8_t* in, uint32_t* out,
+    int num_bits) {
+  if (num_bits == 0 || num_bits > MAX_SIMD_BITS) {
+    return Unpack32Scalar(in, out, num_bits);
+  }
+  const int num_bytes = 4 * num_bits;
+  uint8_t padded[4 * MAX_SIMD_BITS + 16];
+  bool padded_init = false;
+
+  // The two patterns are adjacent in the tables, so each loads as one 256 bit
+  // register with the first 4 values in the low lane and the last 4 in the high lane.
+  const __m256i shuffle = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(simd_tables.shuffle[num_bits]));
+  const __m256i shift = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(simd_tables.shift[num_bits]));
+  const __m256i mask = _mm256_set1_epi32((1U << num_bits) - 1);
+  const int high_offset = simd_tables.group_offset[num_bits][1];
+  for (int block = 0; block < 4; ++block) {
+    int offset = block * num_bits;
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        LoadAddress(in, num_bytes, offset, padded, &padded_init)));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        LoadAddress(in, num_bytes, offset + high_offset, padded, &padded_init)));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    v = _mm256_shuffle_epi8(v, shuffle);
+    v = _mm256_srlv_epi32(v, shift);
+    v = _mm256_and_si256(v, mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + block * 8), v);
+  }
+  return in + num_bytes;
+}
+
+static const UnpackFn unpack32_kernel =
+    CpuInfo::SupportsAvx2() ? BitPacking::Unpack32Avx2 : BitPacking::Unpack32Sse;
+
+const uint8_t* BitPacking::Unpack32(const uint8_t* in, uint32_t* out, int num_bits) {
+  return unpack32_kernel(in, out, num_bits);
+}
+
+}
@@ -0,0 +1,63 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_BIT_PACKING_H
+#define IMPALA_BIT_PACKING_H
+
+#include <boost/cstdint.hpp>
+
+namespace impala {
+
+// Kernels to unpack bit packed values 32 at a time. Values are packed LSB first, as in
+// the bit-packed runs of the RLE hybrid encoding and the DELTA_BINARY_PACKED miniblocks.
+// A group of 32 values of bit width 'num_bits' takes exactly 4 * num_bits bytes, so
+// the kernels never read past the group.
+class BitPacking {
+ public:
+  // Unpacks 32 values of 'num_bits' (0 <= num_bits <= 32) from 'in' into 'out' using
+  // the fastest kernel for this CPU. Returns the pointer past the bytes consumed.
+  static const uint8_t* Unpack32(const uint8_t* in, uint32_t* out, int num_bits);
+
+  // Same as above, converting the values to T.
+  template<typename T>
+  static const uint8_t* Unpack32(const uint8_t* in, T* out, int num_bits);
+
+  // The individual kernels, exposed for tests and benchmarks. The scalar kernel is
+  // fully unrolled for each bit width. The SSE kernel (SSSE3 shuffles + SSE4.1
+  // multiplies) and the AVX2 kernel handle widths up to 25, where a value and its bit
+  // offset fit in a 32 bit lane, and use the scalar kernel for wider values.
+  // Unpack32Avx2() must only be called if CpuInfo::SupportsAvx2().
+  static const uint8_t* Unpack32Scalar(const uint8_t* in, uint32_t* out, int num_bits);
+  static const uint8_t* Unpack32Sse(const uint8_t* in, uint32_t* out, int num_bits);
+  static const uint8_t* Unpack32Avx2(const uint8_t* in, uint32_t* out, int num_bits);
+};
+
+template<typename T>
+inline const uint8_t* BitPacking::Unpack32(const uint8_t* in, T* out, int num_bits) {
+  uint32_t unpacked[32];
+  in = Unpack32(in, unpacked, num_bits);
+  for (int i = 0; i < 32; ++i) out[i] = unpacked[i];
+  return in;
+}
+
+template<>
+inline const uint8_t* BitPacking::Unpack32(const uint8_t* in, int32_t* out,
+    int num_bits) {
+  return Unpack32(in, reinterpret_cast<uint32_t*>(out), num_bits);
+}
+
+}
+
+#endif
@@ -105,10 +105,17 @@ class BitReader {
   BitReader() : buffer_(NULL), max_bytes_(0) {}
 
   // Gets the next value from the buffer.  Returns true if 'v' could be read or false if
-  // there are not enough bytes left. num_bits must be <= 32.
+  // there are not enough bytes left. num_bits must be <= 64.
   template<typename T>
   bool GetValue(int num_bits, T* v);
 
+  // Gets the next 'batch_size' values, each 'num_bits' wide, into 'v'. This is the
+  // same as calling GetValue() 'batch_size' times but checks the bounds only once.
+  // Returns the number of values read, which is less than batch_size only if there
+  // are not enough bytes left.
+  template<typename T>
+  int GetBatch(int num_bits, T* v, int batch_size);
+
   // Reads a 'num_bytes'-sized value from the buffer and stores it in 'v'. T needs to be a
   // little-endian native type and big enough to store 'num_bytes'. The value is assumed
   // to be byte-aligned so the stream will be advanced to the start of the next byte
@@ -116,6 +123,10 @@ class BitReader {
   template<typename T>
   bool GetAligned(int num_bytes, T* v);
 
+  // Advances the stream by 'num_bits' without reading the values. Returns false (and
+  // does not advance) if there are not enough bits left.
+  bool SkipBits(int64_t num_bits);
+
   // Reads a vlq encoded int from the stream.  The encoded int must start at the
   // beginning of a byte. Return false if there were not enough bytes in the buffer.
   bool GetVlqInt(uint64_t* v);
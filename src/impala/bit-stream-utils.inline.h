@@ -17,6 +17,7 @@
 #define IMPALA_UTIL_BIT_STREAM_UTILS_INLINE_H
 
 #include "impala/bit-stream-utils.h"
+#include "impala/bit-packing.h"
 
 namespace impala {
 
@@ -88,8 +89,7 @@ inline bool BitWriter::PutZigZagVlqInt(int32_t v) {
 
 template<typename T>
 inline bool BitReader::GetValue(int num_bits, T* v) {
-  // TODO: revisit this limit if necessary
-  DCHECK_LE(num_bits, 32);
+  DCHECK_LE(num_bits, 64);
   DCHECK_LE(num_bits, sizeof(T) * 8);
 
   if (UNLIKELY(byte_offset_ * 8 + bit_offset_ + num_bits > max_bytes_ * 8)) return false;
@@ -108,14 +108,86 @@ inline bool BitReader::GetValue(int num_bits, T* v) {
       memcpy(&buffered_values_, buffer_ + byte_offset_, bytes_remaining);
     }
 
-    // Read bits of v that crossed into new buffered_values_
-    *v |= BitUtil::TrailingBits(buffered_values_, bit_offset_)
-          << (num_bits - bit_offset_);
+    // Read bits of v that crossed into new buffered_values_. A 64 bit value that
+    // ended exactly at the boundary has none, and shifting by 64 is undefined.
+    if (bit_offset_ > 0) {
+      *v |= BitUtil::TrailingBits(buffered_values_, bit_offset_)
+            << (num_bits - bit_offset_);
+    }
   }
   DCHECK_LE(bit_offset_, 64);
   return true;
 }
 
+template<typename T>
+inline int BitReader::GetBatch(int num_bits, T* v, int batch_size) {
+  DCHECK_LE(num_bits, 64);
+  DCHECK_LE(num_bits, sizeof(T) * 8);
+
+  int64_t bits_left = max_bytes_ * 8LL - (byte_offset_ * 8LL + bit_offset_);
+  if (num_bits > 0 && bits_left < static_cast<int64_t>(num_bits) * batch_size) {
+    batch_size = bits_left / num_bits;
+  }
+
+  // The unpacking kernels are for at most 32 bits. Wider values only come from
+  // INT64 deltas and are read one at a time.
+  if (num_bits > 32) {
+    for (int i = 0; i < batch_size; ++i) GetValue(num_bits, &v[i]);
+    return batch_size;
+  }
+
+  int i = 0;
+  if (batch_size >= 32) {
+    // Values are unpacked 32 at a time, which needs the reader at a byte boundary.
+    // Bit-packed runs start at one, so this usually reads no values.
+    while (i < batch_size && bit_offset_ % 8 != 0) {
+      GetValue(num_bits, &v[i]);
+      ++i;
+    }
+    if (batch_size - i >= 32) {
+      const uint8_t* in = buffer_ + byte_offset_ + bit_offset_ / 8;
+      for (; batch_size - i >= 32; i += 32) {
+        in = BitPacking::Unpack32(in, v + i, num_bits);
+      }
+      byte_offset_ = in - buffer_;
+      bit_offset_ = 0;
+      int bytes_remaining = max_bytes_ - byte_offset_;
+      memcpy(&buffered_values_, buffer_ + byte_offset_, std::min(8, bytes_remaining));
+    }
+  }
+
+  // Work on local copies of the state so it stays in registers for the loop.
+  uint64_t buffered_values = buffered_values_;
+  int byte_offset = byte_offset_;
+  int bit_offset = bit_offset_;
+  for (; i < batch_size; ++i) {
+    uint64_t value =
+        BitUtil::TrailingBits(buffered_values, bit_offset + num_bits) >> bit_offset;
+    bit_offset += num_bits;
+    if (UNLIKELY(bit_offset >= 64)) {
+      byte_offset += 8;
+      bit_offset -= 64;
+
+      int bytes_remaining = max_bytes_ - byte_offset;
+      if (LIKELY(bytes_remaining >= 8)) {
+        memcpy(&buffered_values, buffer_ + byte_offset, 8);
+      } else {
+        memcpy(&buffered_values, buffer_ + byte_offset, bytes_remaining);
+      }
+
+      // Read bits of the value that crossed into the new buffered_values
+      value |= BitUtil::TrailingBits(buffered_values, bit_offset)
+          << (num_bits - bit_offset);
+    }
+    v[i] = value;
+  }
+
+  buffered_values_ = buffered_values;
+  byte_offset_ = byte_offset;
+  bit_offset_ = bit_offset;
+  return batch_size;
+}
+
 template<typename T>
 inline bool BitReader::GetAligned(int num_bytes, T* v) {
   DCHECK_LE(num_bytes, sizeof(T));
@@ -138,6 +210,21 @@ inline bool BitReader::GetAligned(int num_bytes, T* v) {
   return true;
 }
 
+inline bool BitReader::SkipBits(int64_t num_bits) {
+  int64_t bit_pos = byte_offset_ * 8LL + bit_offset_ + num_bits;
+  if (UNLIKELY(bit_pos > max_bytes_ * 8LL)) return false;
+
+  byte_offset_ = bit_pos / 8;
+  bit_offset_ = bit_pos % 8;
+  int bytes_remaining = max_bytes_ - byte_offset_;
+  if (LIKELY(bytes_remaining >= 8)) {
+    memcpy(&buffered_values_, buffer_ + byte_offset_, 8);
+  } else {
+    memcpy(&buffered_values_, buffer_ + byte_offset_, bytes_remaining);
+  }
+  return true;
+}
+
 inline bool BitReader::GetVlqInt(uint64_t* v) {
   *v = 0;
   int shift = 0;
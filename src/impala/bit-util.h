@@ -43,6 +43,22 @@ class BitUtil {
     return (value / factor) * factor;
   }
 
+  // Returns the number of bytes needed to store 'num_bits' bits.
+  static inline int64_t BytesForBits(int64_t num_bits) {
+    return (num_bits + 7) >> 3;
+  }
+
+  // Bitmap accessors. Bits are numbered LSB first within each byte.
+  static inline bool GetBit(const uint8_t* bits, int64_t i) {
+    return (bits[i >> 3] >> (i & 7)) & 1;
+  }
+  static inline void SetBit(uint8_t* bits, int64_t i) {
+    bits[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+  }
+  static inline void ClearBit(uint8_t* bits, int64_t i) {
+    bits[i >> 3] &= static_cast<uint8_t>(~(1 << (i & 7)));
+  }
+
   // Returns the number of set bits in x
   static inline int Popcount(uint64_t x) {
     int count = 0;
@@ -12,12 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef PARQUET_EXAMPLE_UTIL_H
-#define PARQUET_EXAMPLE_UTIL_H
 
-#include <string>
-#include <parquet/parquet.h>
+#ifndef IMPALA_CPU_INFO_H
+#define IMPALA_CPU_INFO_H
 
-bool GetFileMetadata(const std::string& path, parquet::FileMetaData* metadata);
+namespace impala {
+
+// Runtime checks for instruction set extensions beyond the SSE4.2 baseline the
+// library is compiled for. Kernels using them are compiled with the gcc target
+// attribute and selected at startup.
+class CpuInfo {
+ public:
+  // Returns true if the CPU supports AVX2.
+  static bool SupportsAvx2() {
+    // Can be called from static initializers, before the cpu model is set up.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  }
+};
+
+}
 
 #endif
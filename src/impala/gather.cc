@@ -0,0 +1,80 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "impala/gather.h"
+
+#include <immintrin.h>
+
+#include "impala/cpu-info.h"
+
+namespace impala {
+
+typedef void (*Lookup32Fn)(const uint32_t* dictionary, const int32_t* indices,
+    uint32_t* out, int n);
+typedef void (*Lookup64Fn)(const uint64_t* dictionary, const int32_t* indices,
+    uint64_t* out, int n);
+
+void Gather::Lookup32Scalar(const uint32_t* dictionary, const int32_t* indices,
+    uint32_t* out, int n) {
+  DictionaryLookup<uint32_t>(dictionary, indices, out, n);
+}
+
+__attribute__((target("avx2")))
+void Gather::Lookup32Avx2(const uint32_t* dictionary, const int32_t* indices,
+    uint32_t* out, int n) {
+  const int* base = reinterpret_cast<const int*>(dictionary);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+    __m256i v = _mm256_i32gather_epi32(base, idx, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+  }
+  for (; i < n; ++i) out[i] = dictionary[indices[i]];
+}
+
+void Gather::Lookup64Scalar(const uint64_t* dictionary, const int32_t* indices,
+    uint64_t* out, int n) {
+  DictionaryLookup<uint64_t>(dictionary, indices, out, n);
+}
+
+__attribute__((target("avx2")))
+void Gather::Lookup64Avx2(const uint64_t* dictionary, const int32_t* indices,
+    uint64_t* out, int n) {
+  const long long* base = reinterpret_cast<const long long*>(dictionary);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+    __m256i v = _mm256_i32gather_epi64(base, idx, 8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+  }
+  for (; i < n; ++i) out[i] = dictionary[indices[i]];
+}
+
+static const bool use_avx2 = CpuInfo::SupportsAvx2();
+static const Lookup32Fn lookup32_kernel =
+    use_avx2 ? Gather::Lookup32Avx2 : Gather::Lookup32Scalar;
+static const Lookup64Fn lookup64_kernel =
+    use_avx2 ? Gather::Lookup64Avx2 : Gather::Lookup64Scalar;
+
+void Gather::Lookup32(const uint32_t* dictionary, const int32_t* indices,
+    uint32_t* out, int n) {
+  lookup32_kernel(dictionary, indices, out, n);
+}
+
+void Gather::Lookup64(const uint64_t* dictionary, const int32_t* indices,
+    uint64_t* out, int n) {
+  lookup64_kernel(dictionary, indices, out, n);
+}
+
+}
@@ -0,0 +1,88 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_GATHER_H
+#define IMPALA_GATHER_H
+
+#include <boost/cstdint.hpp>
+
+namespace impala {
+
+// Kernels to look up a batch of dictionary indices: out[i] = dictionary[indices[i]].
+// The indices must already be validated against the dictionary length.
+class Gather {
+ public:
+  // Looks up 'n' values of any type.
+  template<typename T>
+  static void DictionaryLookup(const T* dictionary, const int32_t* indices, T* out,
+      int n);
+
+  // Kernels for 4 and 8 byte values, using AVX2 gathers if the CPU supports them.
+  static void Lookup32(const uint32_t* dictionary, const int32_t* indices,
+      uint32_t* out, int n);
+  static void Lookup64(const uint64_t* dictionary, const int32_t* indices,
+      uint64_t* out, int n);
+
+  // The individual kernels, exposed for tests and benchmarks. The AVX2 kernels must
+  // only be called if CpuInfo::SupportsAvx2().
+  static void Lookup32Scalar(const uint32_t* dictionary, const int32_t* indices,
+      uint32_t* out, int n);
+  static void Lookup32Avx2(const uint32_t* dictionary, const int32_t* indices,
+      uint32_t* out, int n);
+  static void Lookup64Scalar(const uint64_t* dictionary, const int32_t* indices,
+      uint64_t* out, int n);
+  static void Lookup64Avx2(const uint64_t* dictionary, const int32_t* indices,
+      uint64_t* out, int n);
+};
+
+template<typename T>
+inline void Gather::DictionaryLookup(const T* dictionary, const int32_t* indices,
+    T* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] = dictionary[indices[i]];
+  }
+}
+
+template<>
+inline void Gather::DictionaryLookup(const int32_t* dictionary, const int32_t* indices,
+    int32_t* out, int n) {
+  Lookup32(reinterpret_cast<const uint32_t*>(dictionary), indices,
+      reinterpret_cast<uint32_t*>(out), n);
+}
+
+template<>
+inline void Gather::DictionaryLookup(const float* dictionary, const int32_t* indices,
+    float* out, int n) {
+  Lookup32(reinterpret_cast<const uint32_t*>(dictionary), indices,
+      reinterpret_cast<uint32_t*>(out), n);
+}
+
+template<>
+inline void Gather::DictionaryLookup(const int64_t* dictionary, const int32_t* indices,
+    int64_t* out, int n) {
+  Lookup64(reinterpret_cast<const uint64_t*>(dictionary), indices,
+      reinterpret_cast<uint64_t*>(out), n);
+}
+
+template<>
+inline void Gather::DictionaryLookup(const double* dictionary, const int32_t* indices,
+    double* out, int n) {
+  Lookup64(reinterpret_cast<const uint64_t*>(dictionary), indices,
+      reinterpret_cast<uint64_t*>(out), n);
+}
+
+}
+
+#endif
@@ -16,9 +16,11 @@
 #define IMPALA_RLE_ENCODING_H
 
 #include <math.h>
+#include <algorithm>
 
 #include "impala/compiler-util.h"
 #include "impala/bit-stream-utils.inline.h"
+#include "impala/gather.h"
 #include "impala/bit-util.h"
 #include "impala/logging.h"
 
@@ -95,7 +97,36 @@ class RleDecoder {
   template<typename T>
   bool Get(T* val);
 
+  // Gets the next 'batch_size' values into 'values'. Repeated runs are written with
+  // a single fill and literal runs are unpacked in bulk. Returns the number of values
+  // read, which is only less than batch_size at the end of the data.
+  template<typename T>
+  int GetBatch(T* values, int batch_size);
+
+  // Gets the next 'batch_size' values, which are indices into 'dictionary', and writes
+  // the dictionary values they refer to into 'values'. Repeated runs are filled with
+  // a single lookup; the indices of literal runs are unpacked in blocks and then
+  // gathered. Returns the number of values read, which is only less than batch_size
+  // at the end of the data, or -1 if an index is not less than dictionary_length.
+  template<typename T>
+  int GetBatchWithDict(const T* dictionary, int dictionary_length, T* values,
+      int batch_size);
+
+  // Skips the next 'num_values' values. Repeated runs are skipped without reading
+  // anything and literal runs are skipped over in bulk. Returns the number of values
+  // skipped, which is only less than num_values at the end of the data.
+  int Skip(int num_values);
+
+  // Like Skip() but also adds the number of skipped values that are equal to 'value'
+  // to *count, e.g. to find how many non-NULLs a run of definition levels covers.
+  // Literal values have to be read for this.
+  int Skip(int num_values, uint64_t value, int* count);
+
  private:
+  // Reads the indicator (and value, for repeated runs) of the next run. Returns false
+  // if there are no more runs.
+  bool NextRun();
+
   BitReader bit_reader_;
   int bit_width_;
   uint64_t current_value_;
@@ -227,25 +258,31 @@ class RleEncoder {
   uint8_t* literal_indicator_byte_;
 };
 
+inline bool RleDecoder::NextRun() {
+  // Read the next run's indicator int, it could be a literal or repeated run
+  // The int is encoded as a vlq-encoded value.
+  uint64_t indicator_value = 0;
+  bool result = bit_reader_.GetVlqInt(&indicator_value);
+  if (!result) return false;
+
+  // lsb indicates if it is a literal run or repeated run
+  bool is_literal = indicator_value & 1;
+  if (is_literal) {
+    literal_count_ = (indicator_value >> 1) * 8;
+  } else {
+    repeat_count_ = indicator_value >> 1;
+    current_value_ = 0;
+    bool result = bit_reader_.GetAligned<uint64_t>(
+        BitUtil::Ceil(bit_width_, 8), &current_value_);
+    DCHECK(result);
+  }
+  return true;
+}
+
 template<typename T>
 inline bool RleDecoder::Get(T* val) {
   if (UNLIKELY(literal_count_ == 0 && repeat_count_ == 0)) {
-    // Read the next run's indicator int, it could be a literal or repeated run
-    // The int is encoded as a vlq-encoded value.
-    uint64_t indicator_value = 0;
-    bool result = bit_reader_.GetVlqInt(&indicator_value);
-    if (!result) return false;
-
-    // lsb indicates if it is a literal run or repeated run
-    bool is_literal = indicator_value & 1;
-    if (is_literal) {
-      literal_count_ = (indicator_value >> 1) * 8;
-    } else {
-      repeat_count_ = indicator_value >> 1;
-      bool result = bit_reader_.GetAligned<T>(
-          BitUtil::Ceil(bit_width_, 8), reinterpret_cast<T*>(&current_value_));
-      DCHECK(result);
-    }
+    if (!NextRun()) return false;
   }
 
   if (LIKELY(repeat_count_ > 0)) {
@@ -261,6 +298,114 @@ inline bool RleDecoder::Get(T* val) {
   return true;
 }
 
+template<typename T>
+inline int RleDecoder::GetBatch(T* values, int batch_size) {
+  int values_read = 0;
+  while (values_read < batch_size) {
+    if (literal_count_ == 0 && repeat_count_ == 0) {
+      if (!NextRun()) break;
+    }
+    if (repeat_count_ > 0) {
+      int n = std::min<int64_t>(batch_size - values_read, repeat_count_);
+      std::fill(values + values_read, values + values_read + n,
+          static_cast<T>(current_value_));
+      repeat_count_ -= n;
+      values_read += n;
+    } else {
+      DCHECK(literal_count_ > 0);
+      int n = std::min<int64_t>(batch_size - values_read, literal_count_);
+      int actual = bit_reader_.GetBatch(bit_width_, values + values_read, n);
+      DCHECK_EQ(actual, n);
+      literal_count_ -= actual;
+      values_read += actual;
+      if (actual != n) break;
+    }
+  }
+  return values_read;
+}
+
+template<typename T>
+inline int RleDecoder::GetBatchWithDict(const T* dictionary, int dictionary_length,
+    T* values, int batch_size) {
+  // Literal runs are unpacked into this buffer a block at a time, so the bounds check
+  // and the lookup each run over a block of indices.
+  const int INDEX_BUFFER_SIZE = 1024;
+  int32_t indices[INDEX_BUFFER_SIZE];
+
+  int values_read = 0;
+  while (values_read < batch_size) {
+    if (literal_count_ == 0 && repeat_count_ == 0) {
+      if (!NextRun()) break;
+    }
+    if (repeat_count_ > 0) {
+      if (UNLIKELY(current_value_ >= static_cast<uint64_t>(dictionary_length))) {
+        return -1;
+      }
+      int n = std::min<int64_t>(batch_size - values_read, repeat_count_);
+      std::fill(values + values_read, values + values_read + n,
+          dictionary[current_value_]);
+      repeat_count_ -= n;
+      values_read += n;
+    } else {
+      DCHECK(literal_count_ > 0);
+      int n = std::min<int64_t>(batch_size - values_read, literal_count_);
+      n = std::min(n, INDEX_BUFFER_SIZE);
+      int actual = bit_reader_.GetBatch(bit_width_, indices, n);
+      DCHECK_EQ(actual, n);
+      // Branch-free max so the check vectorizes; the cast makes negative indices
+      // (from 32 bit wide values) out of range too.
+      uint32_t max_index = 0;
+      for (int i = 0; i < actual; ++i) {
+        max_index = std::max(max_index, static_cast<uint32_t>(indices[i]));
+      }
+      if (UNLIKELY(actual > 0 &&
+          max_index >= static_cast<uint32_t>(dictionary_length))) {
+        return -1;
+      }
+      Gather::DictionaryLookup(dictionary, indices, values + values_read, actual);
+      literal_count_ -= actual;
+      values_read += actual;
+      if (actual != n) break;
+    }
+  }
+  return values_read;
+}
+
+inline int RleDecoder::Skip(int num_values) {
+  return Skip(num_values, 0, NULL);
+}
+
+inline int RleDecoder::Skip(int num_values, uint64_t value, int* count) {
+  int skipped = 0;
+  while (skipped < num_values) {
+    if (literal_count_ == 0 && repeat_count_ == 0) {
+      if (!NextRun()) break;
+    }
+    if (repeat_count_ > 0) {
+      int n = std::min<int64_t>(num_values - skipped, repeat_count_);
+      if (count != NULL && current_value_ == value) *count += n;
+      repeat_count_ -= n;
+      skipped += n;
+    } else {
+      DCHECK(literal_count_ > 0);
+      int n = std::min<int64_t>(num_values - skipped, literal_count_);
+      if (count == NULL) {
+        if (!bit_reader_.SkipBits(static_cast<int64_t>(n) * bit_width_)) break;
+      } else {
+        for (int i = 0; i < n; ++i) {
+          uint64_t v = 0;
+          bool result = bit_reader_.GetValue(bit_width_, &v);
+          DCHECK(result);
+          if (v == value) ++*count;
+        }
+      }
+      literal_count_ -= n;
+      skipped += n;
+    }
+  }
+  return skipped;
+}
+
 // This function buffers input values 8 at a time.  After seeing all 8 values,
 // it decides whether they should be encoded as a literal or repeated run.
 inline bool RleEncoder::Put(uint64_t value) {
@@ -0,0 +1,552 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/io.h"
+#include "parquet/parquet.h"
+#include "parquet/thread-pool.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef PARQUET_HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace parquet_cpp {
+
+// Throws a ParquetException for the failed 'op' on 'path', with the reason from
+// errno.
+static void ThrowIoError(const char* op, const string& path) {
+  stringstream ss;
+  ss << "Could not " << op << " file " << path << ": " << strerror(errno);
+  throw ParquetException(ss.str());
+}
+
+void RandomAccessSource::ReadRanges(const vector<ReadRange>& ranges,
+    const vector<uint8_t*>& buffers) {
+  for (int i = 0; i < ranges.size(); ++i) {
+    if (ReadAt(ranges[i].offset, ranges[i].length, buffers[i]) != ranges[i].length) {
+      ParquetException::EofException();
+    }
+  }
+}
+
+static bool ReadRangeLess(const ReadRange& a, const ReadRange& b) {
+  return a.offset < b.offset;
+}
+
+vector<ReadRange> CoalesceReadRanges(const vector<ReadRange>& ranges,
+    int64_t max_hole_size) {
+  vector<ReadRange> sorted(ranges);
+  sort(sorted.begin(), sorted.end(), ReadRangeLess);
+  vector<ReadRange> result;
+  for (int i = 0; i < sorted.size(); ++i) {
+    const ReadRange& range = sorted[i];
+    if (!result.empty()) {
+      ReadRange* last = &result.back();
+      int64_t last_end = last->offset + last->length;
+      if (range.offset - last_end <= max_hole_size) {
+        last->length = ::max(last_end, range.offset + range.length) - last->offset;
+        continue;
+      }
+    }
+    result.push_back(range);
+  }
+  return result;
+}
+
+LocalFileSource::LocalFileSource(const string& path)
+  : path_(path), fd_(-1), size_(0), modification_time_(0) {
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) ThrowIoError("open", path);
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    int err = errno;
+    close(fd_);
+    errno = err;
+    ThrowIoError("stat", path);
+  }
+  size_ = st.st_size;
+  modification_time_ = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+LocalFileSource::~LocalFileSource() {
+  close(fd_);
+}
+
+int64_t LocalFileSource::ReadAt(int64_t offset, int64_t num_bytes, uint8_t* buffer) {
+  int64_t bytes_read = 0;
+  while (bytes_read < num_bytes) {
+    ssize_t n = pread(fd_, buffer + bytes_read, num_bytes - bytes_read,
+        offset + bytes_read);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ThrowIoError("read", path_);
+    }
+    // End of file.
+    if (n == 0) break;
+    bytes_read += n;
+  }
+  return bytes_read;
+}
+
+void LocalFileSource::WillNeed(int64_t offset, int64_t num_bytes) {
+  if (offset < 0 || num_bytes <= 0) return;
+  // Only a hint, so failures are ignored.
+  posix_fadvise(fd_, offset, num_bytes, POSIX_FADV_WILLNEED);
+}
+
+#ifdef PARQUET_HAVE_IO_URING
+
+// There is no liburing dependency; the ring is set up with the raw system calls as
+// described in io_uring(7).
+class IoUringSource::Ring {
+ public:
+  Ring() : fd_(-1), sq_ring_(MAP_FAILED), cq_ring_(MAP_FAILED), sqes_(MAP_FAILED) {}
+
+  ~Ring() {
+    if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+    if (fd_ >= 0) close(fd_);
+  }
+
+  // Sets up a ring with room for 'num_entries' reads. Returns false if io_uring is
+  // not available.
+  bool Init(int num_entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    fd_ = syscall(__NR_io_uring_setup, num_entries, &params);
+    if (fd_ < 0) return false;
+    num_entries_ = params.sq_entries;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // Newer kernels map both rings at once.
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) sq_ring_size_ = cq_ring_size_ = ::max(sq_ring_size_, cq_ring_size_);
+    sq_ring_ = mmap(NULL, sq_ring_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) return false;
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ = mmap(NULL, cq_ring_size_, PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+      if (cq_ring_ == MAP_FAILED) return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) return false;
+
+    uint8_t* sq = reinterpret_cast<uint8_t*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    uint8_t* cq = reinterpret_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  int num_entries() const { return num_entries_; }
+
+  // Queues a read of 'len' bytes at 'offset' in 'fd' into 'buffer'. 'user_data' is
+  // returned with its completion. At most num_entries() reads may be queued before
+  // Submit().
+  void QueueRead(int fd, int64_t offset, uint32_t len, uint8_t* buffer,
+      uint64_t user_data) {
+    // Only this thread writes the tail; the kernel reads it.
+    uint32_t tail = *sq_tail_;
+    uint32_t index = tail & sq_mask_;
+    io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = len;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  // Submits the 'num_queued' queued reads. Returns the number submitted, which is
+  // only less than num_queued on errors.
+  int Submit(int num_queued) {
+    int num_submitted = 0;
+    while (num_submitted < num_queued) {
+      int ret = syscall(__NR_io_uring_enter, fd_, num_queued - num_submitted, 0, 0,
+          NULL, 0);
+      if (ret < 0 && errno == EINTR) continue;
+      if (ret <= 0) break;
+      num_submitted += ret;
+    }
+    return num_submitted;
+  }
+
+  // Waits for the next completion and returns its user_data and result (bytes read
+  // or -errno). Must only be called for submitted reads. Does not give up when
+  // waiting fails: the read may still write to its buffer until it completes, so
+  // it polls the completion queue instead.
+  void WaitCompletion(uint64_t* user_data, int* result) {
+    while (true) {
+      // Only this thread writes the head; the kernel writes the tail.
+      uint32_t head = *cq_head_;
+      if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        *user_data = cqe.user_data;
+        *result = cqe.res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return;
+      }
+      int ret = syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, NULL,
+          0);
+      if (ret < 0 && errno != EINTR) usleep(100);
+    }
+  }
+
+ private:
+  int fd_;
+  int num_entries_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  void* sqes_;
+  size_t sqes_size_;
+
+  uint32_t* sq_tail_;
+  uint32_t sq_mask_;
+  uint32_t* sq_array_;
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+#else
+
+// Built without the io_uring kernel headers: Init() always fails, so ReadRanges()
+// uses pread().
+class IoUringSource::Ring {
+ public:
+  bool Init(int num_entries) { return false; }
+  int num_entries() const { return 0; }
+  void QueueRead(int fd, int64_t offset, uint32_t len, uint8_t* buffer,
+      uint64_t user_data) {}
+  int Submit(int num_queued) { return 0; }
+  void WaitCompletion(uint64_t* user_data, int* result) {}
+};
+
+#endif
+
+IoUringSource::IoUringSource(const string& path, int queue_depth)
+  : LocalFileSource(path) {
+  if (queue_depth <= 0) throw ParquetException("Invalid queue depth.");
+  ring_.reset(new Ring());
+  if (!ring_->Init(queue_depth)) ring_.reset();
+}
+
+IoUringSource::~IoUringSource() {
+}
+
+void IoUringSource::ReadRanges(const vector<ReadRange>& ranges,
+    const vector<uint8_t*>& buffers) {
+  vector<int64_t> bytes_read(ranges.size(), 0);
+  {
+    boost::lock_guard<boost::mutex> l(ring_lock_);
+    int begin = 0;
+    while (ring_.get() != NULL && begin < ranges.size()) {
+      int end = ::min<int64_t>(begin + ring_->num_entries(), ranges.size());
+      ReadWithRing(ranges, buffers, begin, end, &bytes_read);
+      begin = end;
+    }
+  }
+  // Finish what the ring did not read (short reads, errors or no ring) with pread().
+  for (int i = 0; i < ranges.size(); ++i) {
+    int64_t num_bytes = ranges[i].length - bytes_read[i];
+    if (num_bytes == 0) continue;
+    if (ReadAt(ranges[i].offset + bytes_read[i], num_bytes, buffers[i] + bytes_read[i])
+        != num_bytes) {
+      ParquetException::EofException();
+    }
+  }
+}
+
+void IoUringSource::ReadWithRing(const vector<ReadRange>& ranges,
+    const vector<uint8_t*>& buffers, int begin, int end, vector<int64_t>* bytes_read) {
+  // Larger reads are capped by the kernel anyway and finished with pread().
+  const int64_t MAX_READ_SIZE = 1 << 30;
+  for (int i = begin; i < end; ++i) {
+    ring_->QueueRead(fd(), ranges[i].offset, ::min(ranges[i].length, MAX_READ_SIZE),
+        buffers[i], i);
+  }
+  int num_submitted = ring_->Submit(end - begin);
+  // Reap everything submitted, even if the rest could not be: the kernel may write
+  // into the buffers until then, and closing the ring does not wait for it.
+  for (int i = 0; i < num_submitted; ++i) {
+    uint64_t user_data;
+    int result;
+    ring_->WaitCompletion(&user_data, &result);
+    if (result > 0) (*bytes_read)[user_data] = result;
+  }
+  // The reads that were not submitted are done with pread(); later batches use it
+  // too.
+  if (num_submitted < end - begin) ring_.reset();
+}
+
+MemoryMappedSource::MemoryMappedSource(const string& path)
+  : path_(path), data_(NULL), size_(0), modification_time_(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) ThrowIoError("open", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    ThrowIoError("stat", path);
+  }
+  size_ = st.st_size;
+  modification_time_ = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  // Empty files cannot be mapped; they have nothing to read anyway.
+  if (size_ > 0) {
+    void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      int err = errno;
+      close(fd);
+      errno = err;
+      ThrowIoError("map", path);
+    }
+    data_ = reinterpret_cast<uint8_t*>(data);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+}
+
+MemoryMappedSource::~MemoryMappedSource() {
+  if (data_ != NULL) munmap(data_, size_);
+}
+
+int64_t MemoryMappedSource::ReadAt(int64_t offset, int64_t num_bytes,
+    uint8_t* buffer) {
+  if (offset < 0 || num_bytes < 0) throw ParquetException("Invalid read range.");
+  if (offset >= size_) return 0;
+  num_bytes = ::min(num_bytes, size_ - offset);
+  memcpy(buffer, data_ + offset, num_bytes);
+  return num_bytes;
+}
+
+const uint8_t* MemoryMappedSource::GetRange(int64_t offset, int64_t num_bytes) {
+  if (offset < 0 || num_bytes < 0 || offset + num_bytes > size_) return NULL;
+  return data_ + offset;
+}
+
+void MemoryMappedSource::WillNeed(int64_t offset, int64_t num_bytes) {
+  if (offset < 0 || num_bytes <= 0 || offset >= size_) return;
+  num_bytes = ::min(num_bytes, size_ - offset);
+  // madvise() needs a page aligned start.
+  static const int64_t page_size = sysconf(_SC_PAGESIZE);
+  int64_t start = offset / page_size * page_size;
+  int64_t len = offset + num_bytes - start;
+  // Only hints, so failures are ignored.
+  madvise(data_ + start, len, MADV_SEQUENTIAL);
+  madvise(data_ + start, len, MADV_WILLNEED);
+}
+
+BufferedInputStream::BufferedInputStream(RandomAccessSource* source, int64_t offset,
+    int64_t len, int buffer_size)
+  : source_(source),
+    read_offset_(offset),
+    end_(offset + len),
+    buffer_size_(buffer_size),
+    buffer_pos_(0),
+    buffer_len_(0) {
+  if (offset < 0 || len < 0) throw ParquetException("Invalid read range.");
+  if (buffer_size <= 0) throw ParquetException("Invalid buffer size.");
+}
+
+const uint8_t* BufferedInputStream::Peek(int num_to_peek, int* num_bytes) {
+  if (buffer_len_ - buffer_pos_ < num_to_peek && read_offset_ < end_) {
+    // Move the unconsumed bytes to the front and refill the rest of the buffer.
+    int num_unconsumed = buffer_len_ - buffer_pos_;
+    if (num_unconsumed > 0) {
+      memmove(&buffer_[0], &buffer_[buffer_pos_], num_unconsumed);
+    }
+    buffer_pos_ = 0;
+    buffer_len_ = num_unconsumed;
+    int capacity = ::max(num_to_peek, buffer_size_);
+    if (static_cast<int>(buffer_.size()) < capacity) buffer_.resize(capacity);
+    int64_t num_to_read = ::min<int64_t>(buffer_.size() - buffer_len_,
+        end_ - read_offset_);
+    if (source_->ReadAt(read_offset_, num_to_read, &buffer_[buffer_len_]) !=
+        num_to_read) {
+      ParquetException::EofException();
+    }
+    read_offset_ += num_to_read;
+    buffer_len_ += num_to_read;
+  }
+  *num_bytes = ::min(num_to_peek, buffer_len_ - buffer_pos_);
+  if (*num_bytes == 0) return NULL;
+  return &buffer_[buffer_pos_];
+}
+
+const uint8_t* BufferedInputStream::Read(int num_to_read, int* num_bytes) {
+  const uint8_t* data = Peek(num_to_read, num_bytes);
+  buffer_pos_ += *num_bytes;
+  return data;
+}
+
+PrefetchingInputStream::PrefetchingInputStream(RandomAccessSource* source,
+    int64_t offset, int64_t len, int block_size, int64_t max_buffered_bytes,
+    ThreadPool* pool)
+  : source_(source),
+    pool_(pool != NULL ? pool : ProcessPool()),
+    read_offset_(offset),
+    end_(offset + len),
+    block_size_(block_size),
+    max_buffered_bytes_(max_buffered_bytes),
+    buffer_pos_(0),
+    buffered_bytes_(0),
+    read_scheduled_(false),
+    done_(len == 0),
+    cancelled_(false) {
+  if (offset < 0 || len < 0) throw ParquetException("Invalid read range.");
+  if (block_size <= 0) throw ParquetException("Invalid block size.");
+  boost::lock_guard<boost::mutex> l(lock_);
+  ScheduleRead();
+}
+
+PrefetchingInputStream::~PrefetchingInputStream() {
+  boost::unique_lock<boost::mutex> l(lock_);
+  cancelled_ = true;
+  while (read_scheduled_) block_ready_.wait(l);
+}
+
+ThreadPool* PrefetchingInputStream::ProcessPool() {
+  // Never destroyed, so streams can be used until the process exits.
+  static ThreadPool* pool = new ThreadPool(PROCESS_POOL_THREADS);
+  return pool;
+}
+
+bool PrefetchingInputStream::HasRoomForBlock() const {
+  return buffered_bytes_ == 0 || buffered_bytes_ + block_size_ <= max_buffered_bytes_;
+}
+
+void PrefetchingInputStream::ScheduleRead() {
+  if (read_scheduled_ || done_ || cancelled_ || !HasRoomForBlock()) return;
+  read_scheduled_ = true;
+  pool_->Submit(boost::bind(&PrefetchingInputStream::ReadBlocks, this));
+}
+
+void PrefetchingInputStream::ReadBlocks() {
+  try {
+    while (true) {
+      Block block;
+      {
+        boost::lock_guard<boost::mutex> l(lock_);
+        // NextBlock() submits the task again once there is room.
+        if (done_ || cancelled_ || !HasRoomForBlock()) break;
+        if (free_blocks_.empty()) {
+          block.reset(new vector<uint8_t>());
+        } else {
+          block = free_blocks_.back();
+          free_blocks_.pop_back();
+        }
+      }
+      int64_t num_bytes = ::min<int64_t>(block_size_, end_ - read_offset_);
+      block->resize(num_bytes);
+      if (source_->ReadAt(read_offset_, num_bytes, &(*block)[0]) != num_bytes) {
+        ParquetException::EofException();
+      }
+      read_offset_ += num_bytes;
+      {
+        boost::lock_guard<boost::mutex> l(lock_);
+        blocks_.push_back(block);
+        buffered_bytes_ += num_bytes;
+        if (read_offset_ == end_) done_ = true;
+      }
+      block_ready_.notify_all();
+    }
+  } catch (const std::exception& e) {
+    boost::lock_guard<boost::mutex> l(lock_);
+    error_ = e.what();
+    if (error_.empty()) error_ = "Read ahead failed.";
+    done_ = true;
+  }
+  // Notify under the lock: the stream may be destroyed as soon as it is released.
+  boost::lock_guard<boost::mutex> l(lock_);
+  read_scheduled_ = false;
+  block_ready_.notify_all();
+}
+
+PrefetchingInputStream::Block PrefetchingInputStream::NextBlock() {
+  boost::unique_lock<boost::mutex> l(lock_);
+  while (blocks_.empty() && !done_) block_ready_.wait(l);
+  Block block;
+  if (blocks_.empty()) {
+    if (!error_.empty()) throw ParquetException(error_);
+    return block;
+  }
+  block = blocks_.front();
+  blocks_.pop_front();
+  buffered_bytes_ -= block->size();
+  ScheduleRead();
+  return block;
+}
+
+void PrefetchingInputStream::Fill(int num_bytes) {
+  if (static_cast<int64_t>(buffer_.size()) - buffer_pos_ >= num_bytes) return;
+  buffer_.erase(buffer_.begin(), buffer_.begin() + buffer_pos_);
+  buffer_pos_ = 0;
+  while (static_cast<int64_t>(buffer_.size()) < num_bytes) {
+    Block block = NextBlock();
+    if (block.get() == NULL) break;
+    if (buffer_.empty()) {
+      // Take the block's bytes without a copy; its buffer gets ours.
+      buffer_.swap(*block);
+    } else {
+      buffer_.insert(buffer_.end(), block->begin(), block->end());
+    }
+    boost::lock_guard<boost::mutex> l(lock_);
+    free_blocks_.push_back(block);
+  }
+}
+
+const uint8_t* PrefetchingInputStream::Peek(int num_to_peek, int* num_bytes) {
+  Fill(num_to_peek);
+  *num_bytes = ::min<int64_t>(num_to_peek,
+      static_cast<int64_t>(buffer_.size()) - buffer_pos_);
+  if (*num_bytes == 0) return NULL;
+  return &buffer_[buffer_pos_];
+}
+
+const uint8_t* PrefetchingInputStream::Read(int num_to_read, int* num_bytes) {
+  const uint8_t* data = Peek(num_to_read, num_bytes);
+  buffer_pos_ += *num_bytes;
+  return data;
+}
+
+}
@@ -0,0 +1,165 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/lazy-metadata.h"
+#include "parquet/compact-protocol.h"
+
+using namespace parquet;
+using namespace std;
+
+namespace parquet_cpp {
+
+// Skips the STRUCT elements of the list that 'reader' is at and returns where each
+// one is.
+template <class Range>
+static void ReadStructRanges(CompactProtocolReader* reader, vector<Range>* ranges) {
+  int32_t size;
+  CompactProtocolReader::Type elem_type = reader->ReadListBegin(&size);
+  if (elem_type != CompactProtocolReader::STRUCT) CompactProtocolReader::Corrupt();
+  ranges->resize(size);
+  for (int32_t i = 0; i < size; ++i) {
+    (*ranges)[i].offset = reader->offset();
+    reader->Skip(CompactProtocolReader::STRUCT);
+    (*ranges)[i].len = reader->offset() - (*ranges)[i].offset;
+  }
+}
+
+LazyFileMetaData::LazyFileMetaData(const uint8_t* buf, uint32_t len)
+  : buffer_(buf, buf + len) {
+  CompactProtocolReader reader(buffer_.empty() ? NULL : &buffer_[0], len);
+  // Fields other than row_groups are few and small: they are deserialized from
+  // their ranges like the column chunks.
+  vector<Range> schema;
+  vector<Range> key_value_metadata;
+  int16_t parent_field_id = reader.BeginStruct();
+  int16_t field_id;
+  CompactProtocolReader::Type type;
+  while ((type = reader.ReadFieldBegin(&field_id)) != CompactProtocolReader::STOP) {
+    if (field_id == 1 && type == CompactProtocolReader::I32) {
+      metadata_.version = reader.ReadI32();
+    } else if (field_id == 2 && type == CompactProtocolReader::LIST) {
+      ReadStructRanges(&reader, &schema);
+    } else if (field_id == 3 && type == CompactProtocolReader::I64) {
+      metadata_.num_rows = reader.ReadI64();
+    } else if (field_id == 4 && type == CompactProtocolReader::LIST) {
+      int32_t size;
+      if (reader.ReadListBegin(&size) != CompactProtocolReader::STRUCT) {
+        CompactProtocolReader::Corrupt();
+      }
+      // ReadListBegin() has checked 'size' against the bytes left.
+      row_groups_.resize(size);
+      for (int32_t i = 0; i < size; ++i) ParseRowGroup(&reader, &row_groups_[i]);
+    } else if (field_id == 5 && type == CompactProtocolReader::LIST) {
+      ReadStructRanges(&reader, &key_value_metadata);
+      metadata_.__isset.key_value_metadata = true;
+    } else if (field_id == 6 && type == CompactProtocolReader::BINARY) {
+      reader.ReadString(&metadata_.created_by);
+      metadata_.__isset.created_by = true;
+    } else {
+      reader.Skip(type);
+    }
+  }
+  reader.EndStruct(parent_field_id);
+
+  metadata_.schema.resize(schema.size());
+  for (int i = 0; i < schema.size(); ++i) Deserialize(schema[i], &metadata_.schema[i]);
+  metadata_.key_value_metadata.resize(key_value_metadata.size());
+  for (int i = 0; i < key_value_metadata.size(); ++i) {
+    Deserialize(key_value_metadata[i], &metadata_.key_value_metadata[i]);
+  }
+}
+
+void LazyFileMetaData::ParseRowGroup(CompactProtocolReader* reader,
+    RowGroupLocation* row_group) {
+  row_group->total_byte_size = 0;
+  row_group->num_rows = 0;
+  int16_t parent_field_id = reader->BeginStruct();
+  int16_t field_id;
+  CompactProtocolReader::Type type;
+  while ((type = reader->ReadFieldBegin(&field_id)) != CompactProtocolReader::STOP) {
+    if (field_id == 1 && type == CompactProtocolReader::LIST) {
+      ReadStructRanges(reader, &row_group->columns);
+    } else if (field_id == 2 && type == CompactProtocolReader::I64) {
+      row_group->total_byte_size = reader->ReadI64();
+    } else if (field_id == 3 && type == CompactProtocolReader::I64) {
+      row_group->num_rows = reader->ReadI64();
+    } else if (field_id == 4 && type == CompactProtocolReader::LIST) {
+      ReadStructRanges(reader, &row_group->sorting_columns);
+    } else {
+      reader->Skip(type);
+    }
+  }
+  reader->EndStruct(parent_field_id);
+}
+
+template <class T>
+void LazyFileMetaData::Deserialize(const Range& range, T* msg) const {
+  uint32_t len = range.len;
+  DeserializeThriftMsg(&buffer_[range.offset], &len, msg);
+}
+
+void LazyFileMetaData::CheckRowGroup(int row_group) const {
+  if (row_group < 0 || row_group >= row_groups_.size()) {
+    throw ParquetException("Invalid row group index.");
+  }
+}
+
+void LazyFileMetaData::CheckColumn(int row_group, int column) const {
+  CheckRowGroup(row_group);
+  if (column < 0 || column >= row_groups_[row_group].columns.size()) {
+    throw ParquetException("Invalid column index.");
+  }
+}
+
+int LazyFileMetaData::num_columns(int row_group) const {
+  CheckRowGroup(row_group);
+  return row_groups_[row_group].columns.size();
+}
+
+int64_t LazyFileMetaData::num_rows(int row_group) const {
+  CheckRowGroup(row_group);
+  return row_groups_[row_group].num_rows;
+}
+
+int64_t LazyFileMetaData::total_byte_size(int row_group) const {
+  CheckRowGroup(row_group);
+  return row_groups_[row_group].total_byte_size;
+}
+
+void LazyFileMetaData::GetColumnChunk(int row_group, int column,
+    ColumnChunk* chunk) const {
+  CheckColumn(row_group, column);
+  Deserialize(row_groups_[row_group].columns[column], chunk);
+}
+
+void LazyFileMetaData::GetRowGroup(int row_group, RowGroup* result) const {
+  CheckRowGroup(row_group);
+  const RowGroupLocation& location = row_groups_[row_group];
+  *result = RowGroup();
+  result->total_byte_size = location.total_byte_size;
+  result->num_rows = location.num_rows;
+  result->columns.resize(location.columns.size());
+  for (int i = 0; i < location.columns.size(); ++i) {
+    Deserialize(location.columns[i], &result->columns[i]);
+  }
+  if (!location.sorting_columns.empty()) {
+    result->sorting_columns.resize(location.sorting_columns.size());
+    for (int i = 0; i < location.sorting_columns.size(); ++i) {
+      Deserialize(location.sorting_columns[i], &result->sorting_columns[i]);
+    }
+    result->__isset.sorting_columns = true;
+  }
+}
+
+}
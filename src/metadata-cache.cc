@@ -0,0 +1,165 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/metadata-cache.h"
+
+using namespace boost;
+using namespace parquet;
+using namespace std;
+
+namespace parquet_cpp {
+
+static int64_t EstimateSize(const Statistics& stats) {
+  return stats.min.capacity() + stats.max.capacity();
+}
+
+// Estimates the memory held by the metadata and the schema built from it. Only the
+// repeated parts matter: the schema elements, row groups and column chunks.
+static int64_t EstimateSize(const FileMetaData& metadata) {
+  int64_t size = sizeof(FileMetaData);
+  // Each schema element is in the metadata and in the Schema tree.
+  for (int i = 0; i < metadata.schema.size(); ++i) {
+    size += 2 * sizeof(SchemaElement) + sizeof(Schema::Element) +
+        3 * metadata.schema[i].name.capacity();
+  }
+  for (int i = 0; i < metadata.row_groups.size(); ++i) {
+    const RowGroup& row_group = metadata.row_groups[i];
+    size += sizeof(RowGroup);
+    for (int j = 0; j < row_group.columns.size(); ++j) {
+      const ColumnChunk& column = row_group.columns[j];
+      size += sizeof(ColumnChunk) + column.file_path.capacity() +
+          column.meta_data.encodings.capacity() * sizeof(Encoding::type) +
+          EstimateSize(column.meta_data.statistics);
+      for (int k = 0; k < column.meta_data.path_in_schema.size(); ++k) {
+        size += sizeof(string) + column.meta_data.path_in_schema[k].capacity();
+      }
+    }
+  }
+  for (int i = 0; i < metadata.key_value_metadata.size(); ++i) {
+    size += sizeof(KeyValue) + metadata.key_value_metadata[i].key.capacity() +
+        metadata.key_value_metadata[i].value.capacity();
+  }
+  return size + metadata.created_by.capacity();
+}
+
+bool MetadataCache::Key::operator<(const Key& other) const {
+  if (path != other.path) return path < other.path;
+  if (size != other.size) return size < other.size;
+  return modification_time < other.modification_time;
+}
+
+MetadataCache::MetadataCache(int64_t capacity)
+  : capacity_(capacity), size_(0), hits_(0), misses_(0) {
+}
+
+MetadataCache* MetadataCache::ProcessCache() {
+  // Never destroyed, so it can be used until the process exits.
+  static MetadataCache* cache = new MetadataCache();
+  return cache;
+}
+
+bool MetadataCache::Lookup(const string& path, int64_t size, int64_t modification_time,
+    shared_ptr<const FileMetaData>* metadata, shared_ptr<const Schema>* schema) {
+  Key key;
+  key.path = path;
+  key.size = size;
+  key.modification_time = modification_time;
+  boost::lock_guard<boost::mutex> l(lock_);
+  map<Key, Entry>::iterator it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+  *metadata = it->second.metadata;
+  *schema = it->second.schema;
+  return true;
+}
+
+void MetadataCache::Insert(const string& path, int64_t size, int64_t modification_time,
+    const shared_ptr<const FileMetaData>& metadata,
+    const shared_ptr<const Schema>& schema) {
+  Key key;
+  key.path = path;
+  key.size = size;
+  key.modification_time = modification_time;
+  Entry entry;
+  entry.metadata = metadata;
+  entry.schema = schema;
+  entry.size = EstimateSize(*metadata);
+
+  boost::lock_guard<boost::mutex> l(lock_);
+  map<Key, Entry>::iterator it = entries_.find(key);
+  if (it != entries_.end()) {
+    size_ -= it->second.size;
+    lru_.erase(it->second.lru_position);
+    entries_.erase(it);
+  }
+  if (entry.size > capacity_) return;
+  lru_.push_front(key);
+  entry.lru_position = lru_.begin();
+  entries_[key] = entry;
+  size_ += entry.size;
+  Evict();
+}
+
+void MetadataCache::Evict() {
+  while (size_ > capacity_) {
+    map<Key, Entry>::iterator it = entries_.find(lru_.back());
+    size_ -= it->second.size;
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+void MetadataCache::Clear() {
+  boost::lock_guard<boost::mutex> l(lock_);
+  entries_.clear();
+  lru_.clear();
+  size_ = 0;
+}
+
+int64_t MetadataCache::capacity() const {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return capacity_;
+}
+
+void MetadataCache::set_capacity(int64_t capacity) {
+  boost::lock_guard<boost::mutex> l(lock_);
+  capacity_ = capacity;
+  Evict();
+}
+
+int64_t MetadataCache::size() const {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return size_;
+}
+
+int MetadataCache::num_entries() const {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return entries_.size();
+}
+
+int64_t MetadataCache::hits() const {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return hits_;
+}
+
+int64_t MetadataCache::misses() const {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return misses_;
+}
+
+}
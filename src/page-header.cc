@@ -0,0 +1,142 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/page-header.h"
+#include "parquet/compact-protocol.h"
+
+using namespace parquet;
+using namespace std;
+
+namespace parquet_cpp {
+
+typedef CompactProtocolReader Reader;
+
+static void ReadStatistics(Reader* reader, Statistics* stats) {
+  stats->__isset = _Statistics__isset();
+  int16_t parent_field_id = reader->BeginStruct();
+  int16_t field_id;
+  Reader::Type type;
+  while ((type = reader->ReadFieldBegin(&field_id)) != Reader::STOP) {
+    if (field_id == 1 && type == Reader::BINARY) {
+      reader->ReadString(&stats->max);
+      stats->__isset.max = true;
+    } else if (field_id == 2 && type == Reader::BINARY) {
+      reader->ReadString(&stats->min);
+      stats->__isset.min = true;
+    } else if (field_id == 3 && type == Reader::I64) {
+      stats->null_count = reader->ReadI64();
+      stats->__isset.null_count = true;
+    } else if (field_id == 4 && type == Reader::I64) {
+      stats->distinct_count = reader->ReadI64();
+      stats->__isset.distinct_count = true;
+    } else {
+      reader->Skip(type);
+    }
+  }
+  reader->EndStruct(parent_field_id);
+}
+
+static void ReadDataPageHeader(Reader* reader, DataPageHeader* header) {
+  header->__isset = _DataPageHeader__isset();
+  // Bit i is set once required field i is read.
+  int required = 0;
+  int16_t parent_field_id = reader->BeginStruct();
+  int16_t field_id;
+  Reader::Type type;
+  while ((type = reader->ReadFieldBegin(&field_id)) != Reader::STOP) {
+    if (field_id == 1 && type == Reader::I32) {
+      header->num_values = reader->ReadI32();
+    } else if (field_id == 2 && type == Reader::I32) {
+      header->encoding = static_cast<Encoding::type>(reader->ReadI32());
+    } else if (field_id == 3 && type == Reader::I32) {
+      header->definition_level_encoding =
+          static_cast<Encoding::type>(reader->ReadI32());
+    } else if (field_id == 4 && type == Reader::I32) {
+      header->repetition_level_encoding =
+          static_cast<Encoding::type>(reader->ReadI32());
+    } else if (field_id == 5 && type == Reader::STRUCT) {
+      ReadStatistics(reader, &header->statistics);
+      header->__isset.statistics = true;
+      continue;
+    } else {
+      reader->Skip(type);
+      continue;
+    }
+    required |= 1 << field_id;
+  }
+  reader->EndStruct(parent_field_id);
+  if (required != 0x1e) Reader::Corrupt();
+}
+
+static void ReadDictionaryPageHeader(Reader* reader, DictionaryPageHeader* header) {
+  header->__isset = _DictionaryPageHeader__isset();
+  int required = 0;
+  int16_t parent_field_id = reader->BeginStruct();
+  int16_t field_id;
+  Reader::Type type;
+  while ((type = reader->ReadFieldBegin(&field_id)) != Reader::STOP) {
+    if (field_id == 1 && type == Reader::I32) {
+      header->num_values = reader->ReadI32();
+      required |= 1 << field_id;
+    } else if (field_id == 2 && type == Reader::I32) {
+      header->encoding = static_cast<Encoding::type>(reader->ReadI32());
+      required |= 1 << field_id;
+    } else if (field_id == 3 &&
+        (type == Reader::BOOLEAN_TRUE || type == Reader::BOOLEAN_FALSE)) {
+      header->is_sorted = type == Reader::BOOLEAN_TRUE;
+      header->__isset.is_sorted = true;
+    } else {
+      reader->Skip(type);
+    }
+  }
+  reader->EndStruct(parent_field_id);
+  if (required != 0x6) Reader::Corrupt();
+}
+
+void DeserializePageHeader(const uint8_t* buf, uint32_t* len, PageHeader* header) {
+  Reader reader(buf, *len);
+  header->__isset = _PageHeader__isset();
+  int required = 0;
+  int16_t parent_field_id = reader.BeginStruct();
+  int16_t field_id;
+  Reader::Type type;
+  while ((type = reader.ReadFieldBegin(&field_id)) != Reader::STOP) {
+    if (field_id == 1 && type == Reader::I32) {
+      header->type = static_cast<PageType::type>(reader.ReadI32());
+      required |= 1 << field_id;
+    } else if (field_id == 2 && type == Reader::I32) {
+      header->uncompressed_page_size = reader.ReadI32();
+      required |= 1 << field_id;
+    } else if (field_id == 3 && type == Reader::I32) {
+      header->compressed_page_size = reader.ReadI32();
+      required |= 1 << field_id;
+    } else if (field_id == 4 && type == Reader::I32) {
+      header->crc = reader.ReadI32();
+      header->__isset.crc = true;
+    } else if (field_id == 5 && type == Reader::STRUCT) {
+      ReadDataPageHeader(&reader, &header->data_page_header);
+      header->__isset.data_page_header = true;
+    } else if (field_id == 7 && type == Reader::STRUCT) {
+      ReadDictionaryPageHeader(&reader, &header->dictionary_page_header);
+      header->__isset.dictionary_page_header = true;
+    } else {
+      reader.Skip(type);
+    }
+  }
+  reader.EndStruct(parent_field_id);
+  if (required != 0xe) Reader::Corrupt();
+  *len = reader.offset();
+}
+
+}
@@ -13,15 +13,23 @@
 // limitations under the License.
 
 #include "parquet/parquet.h"
+#include "parquet/page-header.h"
+#include "parquet/thread-pool.h"
 #include "encodings/encodings.h"
 #include "compression/codec.h"
 
+#include <deque>
 #include <string>
 #include <string.h>
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <thrift/protocol/TDebugProtocol.h>
 
-const int DATA_PAGE_SIZE = 64 * 1024;
+// Bytes peeked for a page header at first. Headers with large statistics need more;
+// the peek doubles until the header fits, up to MAX_PAGE_HEADER_SIZE.
+const int DEFAULT_PAGE_HEADER_SIZE = 16 * 1024;
+const int MAX_PAGE_HEADER_SIZE = 16 * 1024 * 1024;
 
 using namespace boost;
 using namespace parquet;
@@ -29,6 +37,22 @@ using namespace std;
 
 namespace parquet_cpp {
 
+ThriftDeserializer::ThriftDeserializer()
+  : transport_(new apache::thrift::transport::TMemoryBuffer()) {
+  ResetProtocol();
+}
+
+void ThriftDeserializer::ResetProtocol() {
+  protocol_.reset(new apache::thrift::protocol::TCompactProtocolT<
+      apache::thrift::transport::TMemoryBuffer>(transport_));
+}
+
+ThriftDeserializer* ThriftDeserializer::ThreadLocal() {
+  static thread_specific_ptr<ThriftDeserializer> deserializer;
+  if (deserializer.get() == NULL) deserializer.reset(new ThriftDeserializer());
+  return deserializer.get();
+}
+
 InMemoryInputStream::InMemoryInputStream(const uint8_t* buffer, int64_t len) :
   buffer_(buffer), len_(len), offset_(0) {
 }
@@ -44,12 +68,208 @@ const uint8_t* InMemoryInputStream::Read(int num_to_read, int* num_bytes) {
   return result;
 }
 
+// Reads the next page header in 'stream' into 'header' and advances past it.
+// Returns false at the end of the stream.
+static bool ReadPageHeader(InputStream* stream, bool thrift_page_headers,
+    PageHeader* header) {
+  int bytes_read = 0;
+  uint32_t header_size = 0;
+  for (int peek_size = DEFAULT_PAGE_HEADER_SIZE; ; peek_size *= 2) {
+    const uint8_t* buffer = stream->Peek(peek_size, &bytes_read);
+    if (bytes_read == 0) return false;
+    header_size = bytes_read;
+    try {
+      if (thrift_page_headers) {
+        DeserializeThriftMsg(buffer, &header_size, header);
+      } else {
+        DeserializePageHeader(buffer, &header_size, header);
+      }
+      break;
+    } catch (const ParquetException& e) {
+      // Retry with more bytes, unless the stream has no more or the header is
+      // unreasonably large (i.e. corrupt).
+      if (bytes_read < peek_size || peek_size >= MAX_PAGE_HEADER_SIZE) throw;
+    }
+  }
+  stream->Read(header_size, &bytes_read);
+  return true;
+}
+
+// Reads the pages of a column chunk ahead of the ColumnReader and decompresses them
+// on Config::decompression_pool. Each page in flight has its own buffers and codec,
+// which are reused for later pages, so codecs need not be thread safe.
+class PagePipeline {
+ public:
+  struct Page {
+    PageHeader header;
+    vector<uint8_t> compressed;
+    vector<uint8_t> uncompressed;
+    scoped_ptr<Codec> codec;
+    // Set by the decompression task, under PagePipeline::lock_.
+    bool done;
+    string error;
+  };
+
+  PagePipeline(InputStream* stream, CompressionCodec::type codec,
+      const ColumnReader::Config& config)
+    : stream_(stream),
+      codec_(codec),
+      config_(config),
+      end_of_stream_(false),
+      num_in_flight_(0) {
+  }
+
+  // Waits for the pages still being decompressed.
+  ~PagePipeline() {
+    boost::unique_lock<boost::mutex> l(lock_);
+    while (num_in_flight_ > 0) page_done_.wait(l);
+  }
+
+  // Returns the next page once it is decompressed, or NULL at the end of the
+  // stream. The page is valid until the next call. If 'rows_to_skip' is not NULL
+  // the caller is skipping that many rows: data pages it would skip entirely are
+  // dropped before they are decompressed and *rows_to_skip is decremented for them.
+  // Pages queued before the skip started are still returned.
+  const Page* NextPage(int64_t* rows_to_skip) {
+    if (current_page_.get() != NULL) {
+      free_pages_.push_back(current_page_);
+      current_page_.reset();
+    }
+    Fill(rows_to_skip);
+    if (pending_pages_.empty()) return NULL;
+    current_page_ = pending_pages_.front();
+    pending_pages_.pop_front();
+    // Keep decompressing ahead while this page is decoded.
+    Fill(rows_to_skip);
+    {
+      boost::unique_lock<boost::mutex> l(lock_);
+      while (!current_page_->done) page_done_.wait(l);
+    }
+    if (!current_page_->error.empty()) throw ParquetException(current_page_->error);
+    return current_page_.get();
+  }
+
+ private:
+  // Returns true if the caller skips 'header' entirely when it has 'rows_to_skip'
+  // rows left to skip (see ColumnReader::ReadNewPage()).
+  static bool IsSkipped(const PageHeader& header, int64_t rows_to_skip) {
+    return header.type == PageType::DATA_PAGE &&
+        header.data_page_header.num_values <= rows_to_skip;
+  }
+
+  // Returns how many of the rows in *rows_to_skip are left once the caller has
+  // skipped the pages already returned or queued.
+  int64_t RowsToSkipAfterQueued(const int64_t* rows_to_skip) const {
+    if (rows_to_skip == NULL) return 0;
+    int64_t remaining = *rows_to_skip;
+    for (int i = -1; i < static_cast<int>(pending_pages_.size()); ++i) {
+      const Page* page = i < 0 ? current_page_.get() : pending_pages_[i].get();
+      if (page == NULL || page->header.type != PageType::DATA_PAGE) continue;
+      // The skip ends in this page, so no later page is skipped.
+      if (!IsSkipped(page->header, remaining)) return 0;
+      remaining -= page->header.data_page_header.num_values;
+    }
+    return remaining;
+  }
+
+  // Reads pages from the stream and queues their decompression until
+  // decompression_pages_ahead pages are pending or the stream ends. Data pages that
+  // the caller skips entirely (see NextPage()) are read past without being queued.
+  void Fill(int64_t* rows_to_skip) {
+    int64_t remaining_rows_to_skip = RowsToSkipAfterQueued(rows_to_skip);
+    while (!end_of_stream_ && pending_pages_.size() < config_.decompression_pages_ahead) {
+      shared_ptr<Page> page;
+      if (free_pages_.empty()) {
+        page.reset(new Page());
+        page->codec.reset(Codec::Create(codec_));
+      } else {
+        page = free_pages_.back();
+        free_pages_.pop_back();
+      }
+      if (!ReadPageHeader(stream_, config_.thrift_page_headers, &page->header)) {
+        free_pages_.push_back(page);
+        end_of_stream_ = true;
+        break;
+      }
+      int compressed_len = page->header.compressed_page_size;
+      if (compressed_len < 0 || page->header.uncompressed_page_size < 0) {
+        throw ParquetException("Invalid page size.");
+      }
+      int bytes_read = 0;
+      const uint8_t* data = stream_->Read(compressed_len, &bytes_read);
+      if (bytes_read != compressed_len) ParquetException::EofException();
+
+      if (page->header.type == PageType::DATA_PAGE && remaining_rows_to_skip > 0) {
+        if (IsSkipped(page->header, remaining_rows_to_skip)) {
+          int num_values = page->header.data_page_header.num_values;
+          *rows_to_skip -= num_values;
+          remaining_rows_to_skip -= num_values;
+          free_pages_.push_back(page);
+          continue;
+        }
+        remaining_rows_to_skip = 0;
+      }
+
+      // The stream's bytes are only valid until its next read.
+      page->compressed.assign(data, data + compressed_len);
+      page->done = false;
+      page->error.clear();
+      {
+        boost::lock_guard<boost::mutex> l(lock_);
+        ++num_in_flight_;
+      }
+      config_.decompression_pool->Submit(
+          boost::bind(&PagePipeline::Decompress, this, page.get()));
+      pending_pages_.push_back(page);
+    }
+  }
+
+  // Decompression task, run on the pool.
+  void Decompress(Page* page) {
+    string error;
+    try {
+      int uncompressed_len = page->header.uncompressed_page_size;
+      if (uncompressed_len > page->uncompressed.size()) {
+        page->uncompressed.resize(uncompressed_len);
+      }
+      page->codec->Decompress(page->compressed.size(),
+          page->compressed.empty() ? NULL : &page->compressed[0], uncompressed_len,
+          page->uncompressed.empty() ? NULL : &page->uncompressed[0]);
+    } catch (const std::exception& e) {
+      error = e.what();
+      if (error.empty()) error = "Page decompression failed.";
+    }
+    // Notify under the lock: the pipeline may be destroyed as soon as it is released.
+    boost::lock_guard<boost::mutex> l(lock_);
+    page->error = error;
+    page->done = true;
+    --num_in_flight_;
+    page_done_.notify_all();
+  }
+
+  InputStream* stream_;
+  const CompressionCodec::type codec_;
+  const ColumnReader::Config config_;
+
+  // Only used by the reader's thread.
+  deque<shared_ptr<Page> > pending_pages_;
+  vector<shared_ptr<Page> > free_pages_;
+  shared_ptr<Page> current_page_;
+  bool end_of_stream_;
+
+  boost::mutex lock_;
+  // Signalled when a page is decompressed.
+  boost::condition_variable page_done_;
+  int num_in_flight_;
+};
+
 ColumnReader::~ColumnReader() {
 }
 
 ColumnReader::ColumnReader(const ColumnMetaData* metadata,
-    const Schema::Element* schema, InputStream* stream)
-  : metadata_(metadata),
+    const Schema::Element* schema, InputStream* stream, const Config& config)
+  : config_(config),
+    metadata_(metadata),
     schema_(schema),
     max_def_level_(schema_->max_def_level()),
     stream_(stream),
@@ -57,106 +277,379 @@ ColumnReader::ColumnReader(const ColumnMetaData* metadata,
     num_buffered_values_(0),
     num_decoded_values_(0),
     buffered_values_offset_(0) {
-  int value_byte_size = 0;
+  if (config_.batch_size <= 0) throw ParquetException("Invalid batch size.");
+  if (config_.adaptive_batch_size && config_.max_batch_size < config_.batch_size) {
+    throw ParquetException("max_batch_size must be at least batch_size.");
+  }
+  decompressor_.reset(Codec::Create(metadata->codec));
+  if (config_.decompression_pool != NULL && decompressor_ != NULL) {
+    if (config_.decompression_pages_ahead <= 0) {
+      throw ParquetException("decompression_pages_ahead must be positive.");
+    }
+    page_pipeline_.reset(new PagePipeline(stream, metadata->codec, config_));
+  }
+}
+
+shared_ptr<ColumnReader> ColumnReader::Make(const ColumnMetaData* metadata,
+    const Schema::Element* schema, InputStream* stream, const Config& config) {
   switch (metadata->type) {
-    case parquet::Type::BOOLEAN:
-      value_byte_size = 1;
-      break;
-    case parquet::Type::INT32:
-      value_byte_size = sizeof(int32_t);
-      break;
-    case parquet::Type::INT64:
-      value_byte_size = sizeof(int64_t);
-      break;
-    case parquet::Type::FLOAT:
-      value_byte_size = sizeof(float);
-      break;
-    case parquet::Type::DOUBLE:
-      value_byte_size = sizeof(double);
-      break;
-    case parquet::Type::BYTE_ARRAY:
-      value_byte_size = sizeof(ByteArray);
-      break;
+    case Type::BOOLEAN:
+      return shared_ptr<ColumnReader>(new BoolReader(metadata, schema, stream,
+          config));
+    case Type::INT32:
+      return shared_ptr<ColumnReader>(new Int32Reader(metadata, schema, stream,
+          config));
+    case Type::INT64:
+      return shared_ptr<ColumnReader>(new Int64Reader(metadata, schema, stream,
+          config));
+    case Type::FLOAT:
+      return shared_ptr<ColumnReader>(new FloatReader(metadata, schema, stream,
+          config));
+    case Type::DOUBLE:
+      return shared_ptr<ColumnReader>(new DoubleReader(metadata, schema, stream,
+          config));
+    case Type::BYTE_ARRAY:
+      return shared_ptr<ColumnReader>(new ByteArrayReader(metadata, schema, stream,
+          config));
     default:
       PARQUET_NOT_YET_IMPLEMENTED("Unsupported type");
   }
+  return shared_ptr<ColumnReader>();
+}
 
-  switch (metadata->codec) {
-    case CompressionCodec::UNCOMPRESSED:
-      break;
-    case CompressionCodec::SNAPPY:
-      decompressor_.reset(new SnappyCodec());
-      break;
-    default:
-      PARQUET_NOT_YET_IMPLEMENTED("Only uncompressed and snappy are supported.");
+int ColumnReader::ReadLevels(int num_levels, int16_t* def_levels,
+    int16_t* rep_levels) {
+  int num_values = num_levels;
+  if (def_level_decoder_.get() != NULL) {
+    if (def_level_decoder_->GetBatch(def_levels, num_levels) != num_levels) {
+      ParquetException::EofException();
+    }
+    num_values = 0;
+    for (int i = 0; i < num_levels; ++i) {
+      num_values += def_levels[i] == max_def_level_;
+    }
   }
+  if (rep_level_decoder_.get() != NULL) {
+    if (rep_level_decoder_->GetBatch(rep_levels, num_levels) != num_levels) {
+      ParquetException::EofException();
+    }
+  }
+  num_buffered_values_ -= num_levels;
+  return num_values;
+}
 
-  config_ = Config::DefaultConfig();
-  values_buffer_.resize(config_.batch_size * value_byte_size);
+bool ColumnReader::IsDictionaryPage() const {
+  return current_decoder_ != NULL &&
+      current_decoder_->encoding() == Encoding::RLE_DICTIONARY;
 }
 
-void ColumnReader::BatchDecode() {
+int64_t ColumnReader::Skip(int64_t num_rows) {
+  if (max_rep_level() > 0) PARQUET_NOT_YET_IMPLEMENTED("Skip() on repeated columns");
+
+  int64_t rows_to_skip = num_rows;
+  while (rows_to_skip > 0) {
+    if (num_buffered_values_ == 0) {
+      if (!ReadNewPage(&rows_to_skip)) break;
+      continue;
+    }
+
+    int num_levels = ::min<int64_t>(rows_to_skip, num_buffered_values_);
+    // Find how many values (non-NULLs) the skipped levels cover.
+    int num_values = num_levels;
+    if (def_level_decoder_.get() != NULL) {
+      num_values = 0;
+      if (def_level_decoder_->Skip(num_levels, max_def_level_, &num_values) !=
+          num_levels) {
+        ParquetException::EofException();
+      }
+    }
+    num_buffered_values_ -= num_levels;
+    rows_to_skip -= num_levels;
+
+    // Values already decoded by GetValue() are skipped first.
+    int from_buffer = ::min(num_values, num_decoded_values_ - buffered_values_offset_);
+    buffered_values_offset_ += from_buffer;
+    num_values -= from_buffer;
+    if (num_values > 0 && current_decoder_->Skip(num_values) != num_values) {
+      ParquetException::EofException();
+    }
+  }
+  return num_rows - rows_to_skip;
+}
+
+// Writes bits [offset, offset + num_levels) of 'valid_bits', setting bit i if
+// def_levels[i] == max_def_level (or unconditionally if def_levels is NULL). Each
+// output byte is built up in a register instead of doing a read-modify-write per
+// bit. Returns the number of cleared bits.
+static int DefLevelsToBitmap(const int16_t* def_levels, int num_levels,
+    int max_def_level, uint8_t* valid_bits, int64_t offset) {
+  if (num_levels == 0) return 0;
+  int null_count = 0;
+  uint8_t* byte = valid_bits + (offset >> 3);
+  int bit = offset & 7;
+  // Preserve the bits before 'offset' in the first byte.
+  uint8_t current = *byte & ((1 << bit) - 1);
+  for (int i = 0; i < num_levels; ++i) {
+    if (def_levels == NULL || def_levels[i] == max_def_level) {
+      current |= 1 << bit;
+    } else {
+      ++null_count;
+    }
+    if (++bit == 8) {
+      *byte++ = current;
+      current = 0;
+      bit = 0;
+    }
+  }
+  // Preserve the bits after the last level in the final byte.
+  if (bit != 0) *byte = current | (*byte & ~((1 << bit) - 1));
+  return null_count;
+}
+
+// Spreads the 'num_values - null_count' dense values at the front of 'values' out to
+// the slots whose bit is set in 'valid_bits'. Works from the back so no value is
+// overwritten before it has been moved; once the write and read positions meet the
+// remaining values are already in place.
+template <typename T>
+static void SpaceValues(T* values, int num_values, int null_count,
+    const uint8_t* valid_bits, int64_t offset) {
+  int idx = num_values - null_count - 1;
+  for (int i = num_values - 1; i > idx; --i) {
+    if (impala::BitUtil::GetBit(valid_bits, offset + i)) values[i] = values[idx--];
+  }
+}
+
+template <Type::type TYPE>
+TypedColumnReader<TYPE>::TypedColumnReader(const ColumnMetaData* metadata,
+    const Schema::Element* schema, InputStream* stream, const Config& config)
+  : ColumnReader(metadata, schema, stream, config),
+    values_buffer_(new T[config_.batch_size]),
+    values_buffer_size_(config_.batch_size),
+    batch_size_(config_.batch_size),
+    scratch_buffer_size_(0) {
+}
+
+template <Type::type TYPE>
+void TypedColumnReader<TYPE>::BatchDecode() {
+  // The buffer is only grown here, once the values in it have all been returned.
+  if (batch_size_ > values_buffer_size_) {
+    values_buffer_.reset(new T[batch_size_]);
+    values_buffer_size_ = batch_size_;
+  }
   buffered_values_offset_ = 0;
-  uint8_t* buf= &values_buffer_[0];
-  int batch_size = config_.batch_size;
-  switch (metadata_->type) {
-    case parquet::Type::BOOLEAN:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<bool*>(buf), batch_size);
-      break;
-    case parquet::Type::INT32:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<int32_t*>(buf), batch_size);
-      break;
-    case parquet::Type::INT64:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<int64_t*>(buf), batch_size);
-      break;
-    case parquet::Type::FLOAT:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<float*>(buf), batch_size);
-      break;
-    case parquet::Type::DOUBLE:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<double*>(buf), batch_size);
-      break;
-    case parquet::Type::BYTE_ARRAY:
-      num_decoded_values_ =
-          current_decoder_->Get(reinterpret_cast<ByteArray*>(buf), batch_size);
-      break;
-    default:
-      PARQUET_NOT_YET_IMPLEMENTED("Unsupported type.");
+  num_decoded_values_ = current_decoder_->Get(values_buffer_.get(), batch_size_);
+
+  if (config_.adaptive_batch_size) {
+    // Double the batch for the next refill, but not past what is left in the page.
+    int page_values = ::min(current_decoder_->values_left(), config_.max_batch_size);
+    if (batch_size_ < page_values) batch_size_ = ::min(2 * batch_size_, page_values);
+  }
+}
+
+template <Type::type TYPE>
+int TypedColumnReader<TYPE>::DecodeValues(T* values, int num_values) {
+  int num_buffered = num_decoded_values_ - buffered_values_offset_;
+  int from_buffer = ::min(num_values, num_buffered);
+  if (from_buffer > 0) {
+    memcpy(values, &values_buffer_[buffered_values_offset_], from_buffer * sizeof(T));
+    buffered_values_offset_ += from_buffer;
   }
+  if (from_buffer == num_values) return num_values;
+  return from_buffer + current_decoder_->Get(values + from_buffer,
+      num_values - from_buffer);
 }
 
+template <Type::type TYPE>
+int64_t TypedColumnReader<TYPE>::ReadBatch(int batch_size, int16_t* def_levels,
+    int16_t* rep_levels, T* values, int64_t* values_read) {
+  *values_read = 0;
+  if (!HasNext()) return 0;
+
+  int num_levels = ::min(batch_size, num_buffered_values_);
+  int values_to_read = ReadLevels(num_levels, def_levels, rep_levels);
+  *values_read = DecodeValues(values, values_to_read);
+  if (*values_read != values_to_read) ParquetException::EofException();
+  return num_levels;
+}
+
+template <Type::type TYPE>
+const typename TypedColumnReader<TYPE>::T* TypedColumnReader<TYPE>::DecodeInPlace(
+    int num_values) {
+  // Values decoded ahead by GetValue() come before the ones left in the page.
+  if (buffered_values_offset_ != num_decoded_values_) return NULL;
+  if (current_decoder_->encoding() != Encoding::PLAIN) return NULL;
+  return static_cast<PlainDecoder<TYPE>*>(current_decoder_)->GetInPlace(num_values);
+}
+
+// Booleans are bit packed and byte arrays are length prefixed; neither is stored as an
+// array of the C type.
+template <>
+const bool* TypedColumnReader<Type::BOOLEAN>::DecodeInPlace(int num_values) {
+  return NULL;
+}
+
+template <>
+const ByteArray* TypedColumnReader<Type::BYTE_ARRAY>::DecodeInPlace(int num_values) {
+  return NULL;
+}
+
+template <Type::type TYPE>
+int64_t TypedColumnReader<TYPE>::ReadBatchZeroCopy(int batch_size,
+    int16_t* def_levels, int16_t* rep_levels, const T** values, int64_t* values_read) {
+  *values = NULL;
+  *values_read = 0;
+  if (!HasNext()) return 0;
+
+  int num_levels = ::min(batch_size, num_buffered_values_);
+  int values_to_read = ReadLevels(num_levels, def_levels, rep_levels);
+  *values = DecodeInPlace(values_to_read);
+  if (*values == NULL) {
+    if (scratch_buffer_size_ < values_to_read) {
+      scratch_buffer_.reset(new T[values_to_read]);
+      scratch_buffer_size_ = values_to_read;
+    }
+    if (DecodeValues(scratch_buffer_.get(), values_to_read) != values_to_read) {
+      ParquetException::EofException();
+    }
+    *values = scratch_buffer_.get();
+  }
+  *values_read = values_to_read;
+  return num_levels;
+}
+
+template <Type::type TYPE>
+int64_t TypedColumnReader<TYPE>::ReadBatchSpaced(int batch_size, int16_t* def_levels,
+    T* values, uint8_t* valid_bits, int64_t valid_bits_offset, int64_t* null_count) {
+  if (max_rep_level() > 0) {
+    PARQUET_NOT_YET_IMPLEMENTED("ReadBatchSpaced() on repeated columns");
+  }
+  *null_count = 0;
+  if (!HasNext()) return 0;
+
+  int num_levels = ::min(batch_size, num_buffered_values_);
+  int values_to_read = ReadLevels(num_levels, def_levels, NULL);
+  int nulls = DefLevelsToBitmap(def_level_decoder_.get() != NULL ? def_levels : NULL,
+      num_levels, max_def_level_, valid_bits, valid_bits_offset);
+  if (DecodeValues(values, values_to_read) != values_to_read) {
+    ParquetException::EofException();
+  }
+  if (nulls > 0) SpaceValues(values, num_levels, nulls, valid_bits, valid_bits_offset);
+  *null_count = nulls;
+  return num_levels;
+}
+
+template <Type::type TYPE>
+int64_t TypedColumnReader<TYPE>::ReadBatchIndices(int batch_size, int16_t* def_levels,
+    int16_t* rep_levels, int32_t* indices, int64_t* indices_read) {
+  *indices_read = 0;
+  if (!HasNext()) return 0;
+  if (!IsDictionaryPage()) {
+    throw ParquetException("ReadBatchIndices() needs a dictionary encoded page.");
+  }
+  // Values decoded ahead by GetValue() have already been looked up.
+  if (buffered_values_offset_ != num_decoded_values_) {
+    throw ParquetException("ReadBatchIndices() cannot follow GetValue() in a page.");
+  }
+
+  int num_levels = ::min(batch_size, num_buffered_values_);
+  int values_to_read = ReadLevels(num_levels, def_levels, rep_levels);
+  *indices_read = static_cast<DictionaryDecoder<TYPE>*>(current_decoder_)->GetIndices(
+      indices, values_to_read);
+  if (*indices_read != values_to_read) ParquetException::EofException();
+  return num_levels;
+}
+
+template <Type::type TYPE>
+const vector<typename TypedColumnReader<TYPE>::T>*
+TypedColumnReader<TYPE>::dictionary() const {
+  unordered_map<Encoding::type, shared_ptr<Decoder> >::const_iterator it =
+      decoders_.find(Encoding::RLE_DICTIONARY);
+  if (it == decoders_.end()) return NULL;
+  return &static_cast<DictionaryDecoder<TYPE>*>(it->second.get())->dictionary();
+}
+
+template <Type::type TYPE>
+Decoder* TypedColumnReader<TYPE>::NewPlainDecoder() {
+  return new PlainDecoder<TYPE>();
+}
+
+template <Type::type TYPE>
+Decoder* TypedColumnReader<TYPE>::NewDictionaryDecoder(const uint8_t* data, int len,
+    int num_values) {
+  PlainDecoder<TYPE> dictionary;
+  dictionary.SetData(num_values, data, len);
+  return new DictionaryDecoder<TYPE>(&dictionary);
+}
+
+template <>
+Decoder* TypedColumnReader<Type::BOOLEAN>::NewPlainDecoder() {
+  return new BoolDecoder();
+}
+
+template <>
+Decoder* TypedColumnReader<Type::BOOLEAN>::NewDictionaryDecoder(const uint8_t* data,
+    int len, int num_values) {
+  throw ParquetException("Boolean cols should not be dictionary encoded.");
+}
+
+template <>
+int64_t TypedColumnReader<Type::BOOLEAN>::ReadBatchIndices(int batch_size,
+    int16_t* def_levels, int16_t* rep_levels, int32_t* indices, int64_t* indices_read) {
+  throw ParquetException("Boolean cols should not be dictionary encoded.");
+}
+
+template <>
+const vector<bool>* TypedColumnReader<Type::BOOLEAN>::dictionary() const {
+  return NULL;
+}
+
+template class TypedColumnReader<Type::BOOLEAN>;
+template class TypedColumnReader<Type::INT32>;
+template class TypedColumnReader<Type::INT64>;
+template class TypedColumnReader<Type::FLOAT>;
+template class TypedColumnReader<Type::DOUBLE>;
+template class TypedColumnReader<Type::BYTE_ARRAY>;
+
 // PLAIN_DICTIONARY is deprecated but used to be used as a dictionary index
 // encoding.
 static bool IsDictionaryIndexEncoding(const Encoding::type& e) {
   return e == Encoding::RLE_DICTIONARY || e == Encoding::PLAIN_DICTIONARY;
 }
 
-bool ColumnReader::ReadNewPage() {
+bool ColumnReader::ReadNewPage(int64_t* rows_to_skip) {
   // Loop until we find the next data page.
 
   while (true) {
-    int bytes_read = 0;
-    const uint8_t* buffer = stream_->Peek(DATA_PAGE_SIZE, &bytes_read);
-    if (bytes_read == 0) return false;
-    uint32_t header_size = bytes_read;
-
-    // TODO: error handling. This breaks if the page is too big.
-    DeserializeThriftMsg(buffer, &header_size, &current_page_header_);
-    stream_->Read(header_size, &bytes_read);
+    const uint8_t* buffer = NULL;
+    if (page_pipeline_.get() != NULL) {
+      const PagePipeline::Page* page = page_pipeline_->NextPage(rows_to_skip);
+      if (page == NULL) return false;
+      current_page_header_ = page->header;
+      buffer = page->uncompressed.empty() ? NULL : &page->uncompressed[0];
+    } else {
+      if (!ReadPageHeader(stream_, config_.thrift_page_headers, &current_page_header_)) {
+        return false;
+      }
+      // Read the compressed data page.
+      int compressed_len = current_page_header_.compressed_page_size;
+      int bytes_read = 0;
+      buffer = stream_->Read(compressed_len, &bytes_read);
+      if (bytes_read != compressed_len) ParquetException::EofException();
+    }
 
     int compressed_len = current_page_header_.compressed_page_size;
     int uncompressed_len = current_page_header_.uncompressed_page_size;
 
-    // Read the compressed data page.
-    buffer = stream_->Read(compressed_len, &bytes_read);
-    if (bytes_read != compressed_len) ParquetException::EofException();
+    // Skip the whole page if the caller is skipping past it. Every level is a row
+    // since Skip() only supports non-repeated columns.
+    if (rows_to_skip != NULL && current_page_header_.type == PageType::DATA_PAGE &&
+        current_page_header_.data_page_header.num_values <= *rows_to_skip) {
+      *rows_to_skip -= current_page_header_.data_page_header.num_values;
+      continue;
+    }
 
-    // Uncompress it if we need to
-    if (decompressor_ != NULL) {
+    // Uncompress it if we need to. Pages from the pipeline already are.
+    if (decompressor_ != NULL && page_pipeline_.get() == NULL) {
       // Grow the uncompressed buffer if we need to.
       if (uncompressed_len > decompression_buffer_.size()) {
         decompression_buffer_.resize(uncompressed_len);
@@ -173,16 +666,17 @@ bool ColumnReader::ReadNewPage() {
         throw ParquetException("Column cannot have more than one dictionary.");
       }
 
-      PlainDecoder dictionary(type());
-      dictionary.SetData(current_page_header_.dictionary_page_header.num_values,
-          buffer, uncompressed_len);
-      shared_ptr<Decoder> decoder(new DictionaryDecoder(type(), &dictionary));
+      shared_ptr<Decoder> decoder(NewDictionaryDecoder(buffer, uncompressed_len,
+          current_page_header_.dictionary_page_header.num_values));
       decoders_[Encoding::RLE_DICTIONARY] = decoder;
       current_decoder_ = decoders_[Encoding::RLE_DICTIONARY].get();
       continue;
     } else if (current_page_header_.type == PageType::DATA_PAGE) {
       // Read a data page.
       num_buffered_values_ = current_page_header_.data_page_header.num_values;
+      // Any values decoded ahead from the previous page are stale now.
+      num_decoded_values_ = 0;
+      buffered_values_offset_ = 0;
 
       // Read the repetition levels.
       if (schema_->max_rep_level() != 0) {
@@ -220,12 +714,7 @@ bool ColumnReader::ReadNewPage() {
       } else {
         switch (encoding) {
           case Encoding::PLAIN: {
-            shared_ptr<Decoder> decoder;
-            if (type() == Type::BOOLEAN) {
-              decoder.reset(new BoolDecoder());
-            } else {
-              decoder.reset(new PlainDecoder(type()));
-            }
+            shared_ptr<Decoder> decoder(NewPlainDecoder());
             decoders_[encoding] = decoder;
             current_decoder_ = decoder.get();
             break;
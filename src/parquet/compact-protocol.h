@@ -0,0 +1,227 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_COMPACT_PROTOCOL_H
+#define PARQUET_COMPACT_PROTOCOL_H
+
+#include <string>
+#include <boost/cstdint.hpp>
+
+#include "parquet/parquet.h"
+
+namespace parquet_cpp {
+
+// Reads thrift compact protocol encoded bytes in place, without a transport or any
+// allocations. This is for walking thrift messages (e.g. to find where each nested
+// struct starts) rather than deserializing them; callers decode the fields they need
+// and Skip() the rest. All functions throw ParquetException past the end of the
+// buffer.
+class CompactProtocolReader {
+ public:
+  // Type ids of the compact protocol.
+  enum Type {
+    STOP = 0,
+    BOOLEAN_TRUE = 1,
+    BOOLEAN_FALSE = 2,
+    BYTE = 3,
+    I16 = 4,
+    I32 = 5,
+    I64 = 6,
+    DOUBLE = 7,
+    BINARY = 8,
+    LIST = 9,
+    SET = 10,
+    MAP = 11,
+    STRUCT = 12
+  };
+
+  CompactProtocolReader(const uint8_t* buffer, int64_t len)
+    : buffer_(buffer), pos_(buffer), end_(buffer + len), last_field_id_(0) {
+  }
+
+  // Offset of the next byte to read from the start of the buffer.
+  int64_t offset() const { return pos_ - buffer_; }
+  const uint8_t* position() const { return pos_; }
+
+  // Starts reading the fields of a struct. Must be matched by EndStruct() once
+  // ReadFieldBegin() returned STOP.
+  int16_t BeginStruct() {
+    int16_t parent_field_id = last_field_id_;
+    last_field_id_ = 0;
+    return parent_field_id;
+  }
+  void EndStruct(int16_t parent_field_id) { last_field_id_ = parent_field_id; }
+
+  // Reads the next field header of the current struct. Returns its type, which is
+  // STOP after the last field. For booleans the value is the type (BOOLEAN_TRUE or
+  // BOOLEAN_FALSE).
+  Type ReadFieldBegin(int16_t* field_id) {
+    uint8_t header = ReadByte();
+    Type type = static_cast<Type>(header & 0x0f);
+    if (type == STOP) return STOP;
+    int delta = header >> 4;
+    if (delta == 0) {
+      *field_id = static_cast<int16_t>(ZigZag(ReadVarint()));
+    } else {
+      *field_id = last_field_id_ + delta;
+    }
+    last_field_id_ = *field_id;
+    return type;
+  }
+
+  // Reads a list or set header. Returns the element type. Every element takes at
+  // least a byte, so sizes larger than the rest of the buffer are rejected before
+  // callers allocate for them.
+  Type ReadListBegin(int32_t* size) {
+    uint8_t header = ReadByte();
+    *size = header >> 4;
+    if (*size == 15) *size = static_cast<int32_t>(ReadVarint());
+    if (*size < 0 || *size > end_ - pos_) Corrupt();
+    return static_cast<Type>(header & 0x0f);
+  }
+
+  uint8_t ReadByte() {
+    if (pos_ >= end_) Corrupt();
+    return *pos_++;
+  }
+
+  int32_t ReadI32() { return static_cast<int32_t>(ZigZag(ReadVarint())); }
+  int64_t ReadI64() { return ZigZag(ReadVarint()); }
+
+  // Reads a BINARY (or string) value in place: *data points into the buffer.
+  void ReadBinary(const uint8_t** data, int32_t* len) {
+    uint64_t size = ReadVarint();
+    if (size > static_cast<uint64_t>(end_ - pos_)) Corrupt();
+    *data = pos_;
+    *len = static_cast<int32_t>(size);
+    pos_ += size;
+  }
+
+  void ReadString(std::string* value) {
+    const uint8_t* data;
+    int32_t len;
+    ReadBinary(&data, &len);
+    value->assign(reinterpret_cast<const char*>(data), len);
+  }
+
+  // Structs, lists, sets and maps nested deeper than this are corrupt. This is
+  // thrift's default recursion limit.
+  static const int MAX_SKIP_DEPTH = 64;
+
+  // Skips a value of 'type'. Boolean fields have no value to skip.
+  void Skip(Type type) { Skip(type, 0); }
+
+  static void Corrupt() { throw ParquetException("Couldn't deserialize thrift."); }
+
+ private:
+  // Skips a value of 'type' that is nested in 'depth' structs or containers.
+  void Skip(Type type, int depth) {
+    switch (type) {
+      case BOOLEAN_TRUE:
+      case BOOLEAN_FALSE:
+        break;
+      case BYTE:
+        ReadByte();
+        break;
+      case I16:
+      case I32:
+      case I64:
+        ReadVarint();
+        break;
+      case DOUBLE:
+        Advance(8);
+        break;
+      case BINARY: {
+        const uint8_t* data;
+        int32_t len;
+        ReadBinary(&data, &len);
+        break;
+      }
+      case LIST:
+      case SET: {
+        if (depth >= MAX_SKIP_DEPTH) Corrupt();
+        int32_t size;
+        Type elem_type = ReadListBegin(&size);
+        SkipElements(elem_type, size, depth + 1);
+        break;
+      }
+      case MAP: {
+        if (depth >= MAX_SKIP_DEPTH) Corrupt();
+        int32_t size = static_cast<int32_t>(ReadVarint());
+        // Every entry takes at least a byte for its key and one for its value.
+        if (size < 0 || size > (end_ - pos_) / 2) Corrupt();
+        if (size == 0) break;
+        uint8_t types = ReadByte();
+        for (int32_t i = 0; i < size; ++i) {
+          SkipElements(static_cast<Type>(types >> 4), 1, depth + 1);
+          SkipElements(static_cast<Type>(types & 0x0f), 1, depth + 1);
+        }
+        break;
+      }
+      case STRUCT: {
+        if (depth >= MAX_SKIP_DEPTH) Corrupt();
+        int16_t parent_field_id = BeginStruct();
+        int16_t field_id;
+        Type field_type;
+        while ((field_type = ReadFieldBegin(&field_id)) != STOP) {
+          Skip(field_type, depth + 1);
+        }
+        EndStruct(parent_field_id);
+        break;
+      }
+      default:
+        Corrupt();
+    }
+  }
+
+  // Skips 'num' elements of a list, set or map. Booleans in them take a byte each.
+  void SkipElements(Type type, int32_t num, int depth) {
+    for (int32_t i = 0; i < num; ++i) {
+      if (type == BOOLEAN_TRUE || type == BOOLEAN_FALSE) {
+        ReadByte();
+      } else {
+        Skip(type, depth);
+      }
+    }
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = ReadByte();
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return result;
+    }
+    Corrupt();
+    return 0;
+  }
+
+  static int64_t ZigZag(uint64_t n) {
+    return static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1);
+  }
+
+  void Advance(int64_t num_bytes) {
+    if (num_bytes > end_ - pos_) Corrupt();
+    pos_ += num_bytes;
+  }
+
+  const uint8_t* buffer_;
+  const uint8_t* pos_;
+  const uint8_t* end_;
+  int16_t last_field_id_;
+};
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_FILE_READER_H
+#define PARQUET_FILE_READER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "parquet/io.h"
+#include "parquet/lazy-metadata.h"
+#include "parquet/metadata-cache.h"
+#include "parquet/parquet.h"
+#include "parquet/schema.h"
+
+namespace parquet_cpp {
+
+class ParquetFileReader;
+
+// Reads the column chunks of one row group. Not thread safe: threads reading the same
+// row group should each get their own RowGroupReader from the ParquetFileReader.
+class RowGroupReader {
+ public:
+  int num_columns() const { return num_columns_; }
+  int64_t num_rows() const { return num_rows_; }
+
+  // Returns the metadata of column chunk i. With a lazy footer, the chunk is
+  // deserialized on the first call.
+  const parquet::ColumnMetaData& column_metadata(int i) const;
+
+  // Default for LoadColumns(). A hole this size costs about as much as a seek on a
+  // spinning disk.
+  static const int64_t DEFAULT_MAX_HOLE_SIZE = 1024 * 1024;
+
+  // Reads the chunks of 'columns' into memory with as few reads as possible: chunks
+  // separated by at most 'max_hole_size' bytes are read together (see
+  // CoalesceReadRanges()). ColumnStream() and Column() then return streams over the
+  // loaded bytes for these columns. Chunks the source has in memory are not loaded.
+  void LoadColumns(const std::vector<int>& columns,
+      int64_t max_hole_size = DEFAULT_MAX_HOLE_SIZE);
+
+  // Same as above for the same columns of several row groups of one file. All the
+  // reads are issued as one batch (RandomAccessSource::ReadRanges()), so sources
+  // like IoUringSource have them in flight at once.
+  static void LoadColumns(const std::vector<RowGroupReader*>& row_groups,
+      const std::vector<int>& columns, int64_t max_hole_size = DEFAULT_MAX_HOLE_SIZE);
+
+  // Returns a stream over column chunk i (its dictionary page and all data pages).
+  // If the chunk was loaded with LoadColumns() or the source has it in memory, the
+  // stream is over those bytes. Otherwise the file reader's settings pick how the
+  // chunk is read: in the background as it is consumed (read_ahead_bytes()),
+  // through a buffer (stream_buffer_size()), or, by default, all of it up front.
+  // Each call starts over. The stream is owned by this RowGroupReader.
+  InputStream* ColumnStream(int i);
+
+  // Returns a reader for column i, reading the chunk with ColumnStream(). The
+  // ColumnReader must not outlive this RowGroupReader.
+  boost::shared_ptr<ColumnReader> Column(int i,
+      const ColumnReader::Config& config = ColumnReader::Config::DefaultConfig());
+
+ private:
+  friend class ParquetFileReader;
+  RowGroupReader(ParquetFileReader* file, int row_group_idx);
+
+  // A column chunk and the stream over it. 'buffer' is only used if the whole chunk
+  // is read up front.
+  struct ColumnChunkData {
+    std::vector<uint8_t> buffer;
+    boost::scoped_ptr<InputStream> stream;
+  };
+
+  ParquetFileReader* file_;
+  int row_group_idx_;
+  int num_columns_;
+  int64_t num_rows_;
+  // NULL if the file's footer is lazy; the column chunks are then in lazy_columns_.
+  const parquet::RowGroup* row_group_;
+  mutable std::vector<boost::shared_ptr<parquet::ColumnChunk> > lazy_columns_;
+  std::vector<boost::shared_ptr<ColumnChunkData> > column_data_;
+
+  // The buffers read by LoadColumns() and the start of each loaded chunk in them.
+  std::vector<boost::shared_ptr<std::vector<uint8_t> > > loaded_buffers_;
+  std::map<int, const uint8_t*> loaded_columns_;
+};
+
+// Entry point for reading a parquet file. Parses the footer once; row groups are
+// then read through RowGroupReaders, which create the ColumnReaders with streams
+// over the right byte ranges. All reads go through a RandomAccessSource, so readers
+// for different row groups can be used from different threads.
+class ParquetFileReader {
+ public:
+  // How Open() reads a local file.
+  enum IoMode {
+    // pread() (LocalFileSource).
+    PREAD,
+    // Maps the file into memory; column chunks are read from the mapping without
+    // copies (MemoryMappedSource).
+    MMAP,
+    // Batched reads through io_uring, pread() otherwise (IoUringSource).
+    IO_URING
+  };
+
+  // Opens the local file at 'path' and reads its footer. Throws ParquetException if
+  // the file cannot be read or is not a parquet file. The footer is looked up in
+  // 'cache' first and added to it after parsing; NULL always parses it.
+  static boost::shared_ptr<ParquetFileReader> Open(const std::string& path,
+      IoMode io_mode = PREAD, MetadataCache* cache = MetadataCache::ProcessCache());
+
+  // Default for the constructor's footer_read_size. Most footers fit.
+  static const int64_t DEFAULT_FOOTER_READ_SIZE = 64 * 1024;
+
+  // Reads the footer of the file in 'source'. Throws ParquetException if it is not a
+  // parquet file. The last 'footer_read_size' bytes of the file are read at once, so
+  // a footer that fits in them takes a single read; larger ones take a second read.
+  // If 'lazy_footer' is true, the row groups are not deserialized: each column
+  // chunk's metadata is deserialized when a RowGroupReader first needs it (see
+  // LazyFileMetaData). This is much cheaper for wide files or files with many row
+  // groups when only a few column chunks are read.
+  explicit ParquetFileReader(boost::shared_ptr<RandomAccessSource> source,
+      int64_t footer_read_size = DEFAULT_FOOTER_READ_SIZE, bool lazy_footer = false);
+
+  // Reader for the file in 'source' with a footer that was already parsed, e.g. by
+  // another reader of the same file. 'schema' must be built from 'metadata'.
+  ParquetFileReader(boost::shared_ptr<RandomAccessSource> source,
+      const boost::shared_ptr<const parquet::FileMetaData>& metadata,
+      const boost::shared_ptr<const Schema>& schema);
+
+  // The file's metadata. With a lazy footer, its row_groups are empty; use
+  // lazy_metadata() or RowGroupReader::column_metadata().
+  const parquet::FileMetaData& metadata() const { return *metadata_; }
+  const boost::shared_ptr<const parquet::FileMetaData>& shared_metadata() const {
+    return metadata_;
+  }
+  // The file's schema. It may be shared with other readers of the file, so it is
+  // const; use mutable_schema() to set a projection.
+  const Schema* schema() const { return schema_.get(); }
+  const boost::shared_ptr<const Schema>& shared_schema() const { return schema_; }
+  // A copy of the schema owned by this reader, built on the first call, which
+  // callers can set a projection on. WillReadRowGroups() uses its projection.
+  Schema* mutable_schema();
+  // NULL unless the footer is lazy.
+  const LazyFileMetaData* lazy_metadata() const { return lazy_metadata_.get(); }
+  int num_row_groups() const {
+    return lazy_metadata_.get() != NULL ?
+        lazy_metadata_->num_row_groups() : metadata_->row_groups.size();
+  }
+  RandomAccessSource* source() const { return source_.get(); }
+
+  // Returns a reader for row group i. The ParquetFileReader must outlive it.
+  boost::shared_ptr<RowGroupReader> RowGroup(int i);
+
+  // Bytes of each column chunk to read ahead in the background while its pages are
+  // decoded (see PrefetchingInputStream). This bounds the memory each column stream
+  // holds, instead of the whole chunk. 0, the default, reads whole chunks up front.
+  // Applies to the column streams created afterwards.
+  int64_t read_ahead_bytes() const { return read_ahead_bytes_; }
+  void set_read_ahead_bytes(int64_t bytes) { read_ahead_bytes_ = bytes; }
+
+  // If > 0 (and read_ahead_bytes() is 0), column streams read their chunk through a
+  // buffer of this size (see BufferedInputStream) instead of all of it up front, so
+  // chunks of any size are scanned with about the memory of their largest page.
+  // 0, the default, reads whole chunks. Applies to the column streams created
+  // afterwards.
+  int stream_buffer_size() const { return stream_buffer_size_; }
+  void set_stream_buffer_size(int bytes) { stream_buffer_size_ = bytes; }
+
+  // Hints that 'row_groups' will be read next, in this order. The source is asked to
+  // start reading their projected column chunks (RandomAccessSource::WillNeed()), so
+  // read ahead continues past the end of the row group being decoded.
+  void WillReadRowGroups(const std::vector<int>& row_groups);
+
+ private:
+  // Reads and deserializes the footer into metadata_ (and lazy_metadata_ if
+  // 'lazy_footer').
+  void ReadFooter(int64_t footer_read_size, bool lazy_footer);
+
+  boost::shared_ptr<RandomAccessSource> source_;
+  boost::shared_ptr<const parquet::FileMetaData> metadata_;
+  boost::shared_ptr<const LazyFileMetaData> lazy_metadata_;
+  boost::shared_ptr<const Schema> schema_;
+  // Set by mutable_schema().
+  boost::shared_ptr<Schema> mutable_schema_;
+  int64_t read_ahead_bytes_;
+  int stream_buffer_size_;
+};
+
+}
+
+#endif
@@ -221,8 +221,6 @@ class RecordReader {
       const std::vector<const parquet::ColumnMetaData*>& projected_metadata,
       const std::vector<InputStream*>& streams);
 
-  ~RecordReader();
-
   int64_t rows_left() const {
     return metadata_->row_groups[row_group_idx_].num_rows - rows_returned_;
   }
@@ -232,14 +230,27 @@ class RecordReader {
 
  private:
   struct ColumnState {
-    ColumnReader* reader;
+    boost::shared_ptr<ColumnReader> reader;
     const Schema::Element* schema;
     boost::shared_ptr<GenericDatum> datum;
     int rep_level;
     int def_level;
 
-    ColumnState() : reader(NULL) {}
+    // The current batch read from 'reader'. 'values' only contains the
+    // non-null values.
+    std::vector<int16_t> def_levels;
+    std::vector<int16_t> rep_levels;
+    std::vector<uint8_t> values;
+    int num_levels;
+    int level_idx;
+    int value_idx;
+
+    ColumnState() : num_levels(0), level_idx(0), value_idx(0) {}
     void ReadNext();
+
+   private:
+    // Reads the next batch of levels and values from 'reader'.
+    void ReadBatch();
   };
 
   const Schema* schema_;
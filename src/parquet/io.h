@@ -0,0 +1,296 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_IO_H
+#define PARQUET_IO_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "parquet/parquet.h"
+
+namespace parquet_cpp {
+
+// A byte range of a source.
+struct ReadRange {
+  int64_t offset;
+  int64_t length;
+
+  ReadRange(int64_t offset, int64_t length) : offset(offset), length(length) {}
+};
+
+// Random access to the bytes of a file. Unlike InputStream, which is a forward only
+// view of one column chunk, a source serves reads at arbitrary offsets and
+// implementations must allow concurrent ReadAt() calls, so one source can be shared
+// by the readers of all row groups and columns of a file.
+class RandomAccessSource {
+ public:
+  virtual ~RandomAccessSource() {}
+
+  // Returns the size of the file in bytes.
+  virtual int64_t Size() const = 0;
+
+  // Reads 'num_bytes' starting at 'offset' into 'buffer'. Returns the number of
+  // bytes read, which is only less than num_bytes if the file ends first. Throws
+  // ParquetException on IO errors.
+  virtual int64_t ReadAt(int64_t offset, int64_t num_bytes, uint8_t* buffer) = 0;
+
+  // Reads each of 'ranges' into the buffer at the same index of 'buffers', which
+  // must hold the whole range. Sources that can have several reads in flight issue
+  // them all at once; the default reads them one after the other with ReadAt().
+  // Throws ParquetException on IO errors or if a range is past the end of the file.
+  virtual void ReadRanges(const std::vector<ReadRange>& ranges,
+      const std::vector<uint8_t*>& buffers);
+
+  // Returns a pointer to the 'num_bytes' at 'offset' if the source already has them
+  // in memory, so callers can use them in place instead of copying them out with
+  // ReadAt(). The memory stays valid for the life of the source. Returns NULL if
+  // the source does not support this (the default) or the range is not in the file.
+  virtual const uint8_t* GetRange(int64_t offset, int64_t num_bytes) { return NULL; }
+
+  // Hints that the 'num_bytes' at 'offset' will be read soon, front to back. The
+  // default ignores the hint.
+  virtual void WillNeed(int64_t offset, int64_t num_bytes) {}
+
+ protected:
+  RandomAccessSource() {}
+};
+
+// Plans the reads for 'ranges': returns them sorted by offset, with ranges that
+// overlap or are separated by at most 'max_hole_size' bytes merged into one read
+// (which also reads the hole). Every input range is contained in one result range.
+// Fewer, larger reads matter most where each read has a high fixed cost, e.g.
+// seeks on spinning disks or requests to network filesystems.
+std::vector<ReadRange> CoalesceReadRanges(const std::vector<ReadRange>& ranges,
+    int64_t max_hole_size);
+
+// Source for a local file. Reads use pread(), which does not move a shared file
+// position, so threads can read through the same descriptor without locking.
+// WillNeed() starts the kernel's read ahead (posix_fadvise WILLNEED).
+class LocalFileSource : public RandomAccessSource {
+ public:
+  // Opens 'path' for reading. Throws ParquetException if it cannot be opened.
+  explicit LocalFileSource(const std::string& path);
+  virtual ~LocalFileSource();
+
+  virtual int64_t Size() const { return size_; }
+  virtual int64_t ReadAt(int64_t offset, int64_t num_bytes, uint8_t* buffer);
+  virtual void WillNeed(int64_t offset, int64_t num_bytes);
+
+  const std::string& path() const { return path_; }
+  // When the file was last modified, in nanoseconds since the epoch, as of opening.
+  int64_t modification_time() const { return modification_time_; }
+
+ protected:
+  int fd() const { return fd_; }
+
+ private:
+  std::string path_;
+  int fd_;
+  int64_t size_;
+  int64_t modification_time_;
+};
+
+// Source for a local file that issues the reads of ReadRanges() through io_uring,
+// so a whole batch (e.g. the chunks of several row groups) is in flight at once and
+// completes without a thread per read. ReadAt() uses pread(). If io_uring is not
+// available (older kernels, blocked by a seccomp policy, or built with kernel headers
+// that lack it), or fails, ReadRanges() falls back to pread() too.
+// This is a batched but blocking use of io_uring: ReadRanges() submits the batch and
+// waits for all of it before returning, there is no completion or buffer pool API
+// to overlap the reads with other work, and the file's single ring serves one
+// ReadRanges() call at a time, so concurrent callers are serialized. Every read the
+// kernel accepted is reaped before ReadRanges() returns or falls back to pread(),
+// so the kernel never writes to the buffers after that.
+class IoUringSource : public LocalFileSource {
+ public:
+  // Reads submitted at once.
+  static const int DEFAULT_QUEUE_DEPTH = 64;
+
+  // Opens 'path' for reading. Throws ParquetException if it cannot be opened.
+  explicit IoUringSource(const std::string& path,
+      int queue_depth = DEFAULT_QUEUE_DEPTH);
+  virtual ~IoUringSource();
+
+  virtual void ReadRanges(const std::vector<ReadRange>& ranges,
+      const std::vector<uint8_t*>& buffers);
+
+  // Returns false if ReadRanges() uses pread() because io_uring is not available.
+  bool io_uring_enabled() const { return ring_.get() != NULL; }
+
+ private:
+  // The submission and completion queues shared with the kernel. Defined in io.cc
+  // to keep the Linux headers out of this one.
+  class Ring;
+
+  // Reads ranges [begin, end), at most the queue depth, through the ring. Sets
+  // bytes_read[i] to the bytes read for range i, or 0 if it failed or was not
+  // submitted. Waits for every submitted read to complete. Resets ring_ if not all
+  // reads could be submitted.
+  void ReadWithRing(const std::vector<ReadRange>& ranges,
+      const std::vector<uint8_t*>& buffers, int begin, int end,
+      std::vector<int64_t>* bytes_read);
+
+  // Protects ring_: the queues are used by one batch at a time.
+  boost::mutex ring_lock_;
+  boost::scoped_ptr<Ring> ring_;
+};
+
+// Source that maps a local file into memory once. GetRange() returns pointers into
+// the mapping, so column chunks are read straight from the page cache without a
+// copy, and WillNeed() tells the kernel to read ahead (madvise SEQUENTIAL and
+// WILLNEED) over just the chunks that are read.
+class MemoryMappedSource : public RandomAccessSource {
+ public:
+  // Maps 'path'. Throws ParquetException if it cannot be opened or mapped.
+  explicit MemoryMappedSource(const std::string& path);
+  virtual ~MemoryMappedSource();
+
+  virtual int64_t Size() const { return size_; }
+  virtual int64_t ReadAt(int64_t offset, int64_t num_bytes, uint8_t* buffer);
+  virtual const uint8_t* GetRange(int64_t offset, int64_t num_bytes);
+  virtual void WillNeed(int64_t offset, int64_t num_bytes);
+
+  const std::string& path() const { return path_; }
+  int64_t modification_time() const { return modification_time_; }
+
+ private:
+  std::string path_;
+  uint8_t* data_;
+  int64_t size_;
+  int64_t modification_time_;
+};
+
+// InputStream over a byte range of a source that reads it through one buffer, so a
+// column chunk of any size is scanned with the memory of its largest page (plus
+// the buffer). The buffer is reused for every read and grows when a Peek()/Read()
+// asks for more, e.g. a large page or page header.
+class BufferedInputStream : public InputStream {
+ public:
+  static const int DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+  // Streams the 'len' bytes at 'offset' in 'source', which must outlive the stream.
+  BufferedInputStream(RandomAccessSource* source, int64_t offset, int64_t len,
+      int buffer_size = DEFAULT_BUFFER_SIZE);
+
+  virtual const uint8_t* Peek(int num_to_peek, int* num_bytes);
+  virtual const uint8_t* Read(int num_to_read, int* num_bytes);
+
+ private:
+  RandomAccessSource* source_;
+  // Offset of the next read from the source and the end of the range.
+  int64_t read_offset_;
+  const int64_t end_;
+  const int buffer_size_;
+
+  // buffer_[buffer_pos_, buffer_len_) holds the bytes read but not yet consumed.
+  std::vector<uint8_t> buffer_;
+  int buffer_pos_;
+  int buffer_len_;
+};
+
+// InputStream over a byte range of a source that reads ahead in the background, so
+// the IO for the next pages overlaps with decoding the current one. The range is
+// read in blocks of block_size and at most max_buffered_bytes are read ahead of the
+// caller (plus the bytes of the current Peek()/Read()), so memory use does not
+// depend on the size of the range. Blocks are recycled once consumed.
+// The reads run as tasks on a ThreadPool shared by many streams rather than on a
+// thread per stream, so the number of IO threads stays bounded however many columns
+// are read at once. A task reads blocks until the budget is full and then returns
+// its thread to the pool; consuming a block submits the next task.
+class PrefetchingInputStream : public InputStream {
+ public:
+  static const int DEFAULT_BLOCK_SIZE = 1024 * 1024;
+  static const int64_t DEFAULT_MAX_BUFFERED_BYTES = 4 * 1024 * 1024;
+  // Threads of ProcessPool().
+  static const int PROCESS_POOL_THREADS = 8;
+
+  // Streams the 'len' bytes at 'offset' in 'source', which must outlive the stream.
+  // Reading starts immediately, on 'pool' or on ProcessPool() if it is NULL. The
+  // pool must outlive the stream. IO errors are thrown from the Peek()/Read() that
+  // needs the failed bytes.
+  PrefetchingInputStream(RandomAccessSource* source, int64_t offset, int64_t len,
+      int block_size = DEFAULT_BLOCK_SIZE,
+      int64_t max_buffered_bytes = DEFAULT_MAX_BUFFERED_BYTES,
+      ThreadPool* pool = NULL);
+
+  // Stops the background read and waits for a read in progress.
+  virtual ~PrefetchingInputStream();
+
+  virtual const uint8_t* Peek(int num_to_peek, int* num_bytes);
+  virtual const uint8_t* Read(int num_to_read, int* num_bytes);
+
+  // The pool shared by the streams that are not given one. Never destroyed.
+  static ThreadPool* ProcessPool();
+
+ private:
+  typedef boost::shared_ptr<std::vector<uint8_t> > Block;
+
+  // Read task, run on pool_: reads blocks until the budget is full, the end of the
+  // range, an error or cancellation.
+  void ReadBlocks();
+
+  // Submits ReadBlocks() unless it is already submitted, there is nothing left to
+  // read or no room for another block. Must be called with lock_ held.
+  void ScheduleRead();
+
+  // Returns true if another block fits in the budget. Always allows one block, so a
+  // budget below the block size still progresses. Must be called with lock_ held.
+  bool HasRoomForBlock() const;
+
+  // Makes at least 'num_bytes' available in buffer_ from buffer_pos_, unless the
+  // range ends first.
+  void Fill(int num_bytes);
+
+  // Waits for the next block read ahead. Returns an empty Block at the end of the
+  // range. Throws if the background read failed.
+  Block NextBlock();
+
+  RandomAccessSource* source_;
+  ThreadPool* pool_;
+  // Next offset the read task reads and the end of the range. Only used by the read
+  // task, which runs once at a time.
+  int64_t read_offset_;
+  const int64_t end_;
+  const int block_size_;
+  const int64_t max_buffered_bytes_;
+
+  // The bytes handed out by Peek()/Read(): the unread bytes start at buffer_pos_.
+  // Only used by the caller's thread.
+  std::vector<uint8_t> buffer_;
+  int buffer_pos_;
+
+  // State shared with the read task, protected by lock_.
+  boost::mutex lock_;
+  // Signalled when a block is queued or the read task returns.
+  boost::condition_variable block_ready_;
+  std::deque<Block> blocks_;
+  std::vector<Block> free_blocks_;
+  int64_t buffered_bytes_;
+  // True while ReadBlocks() is submitted or running.
+  bool read_scheduled_;
+  // Set once the whole range is read or the read failed.
+  bool done_;
+  bool cancelled_;
+  std::string error_;
+};
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_LAZY_METADATA_H
+#define PARQUET_LAZY_METADATA_H
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include "parquet/parquet.h"
+
+namespace parquet_cpp {
+
+class CompactProtocolReader;
+
+// A file's footer (the serialized FileMetaData) that is deserialized on demand.
+// Parsing only deserializes the top level fields and walks over the row groups to
+// record where each column chunk is; a ColumnChunk is deserialized when it is asked
+// for. For files with many columns or row groups this is much cheaper than
+// deserializing the whole footer when only a few column chunks are read.
+// Thread safe: the accessors do not modify the object.
+class LazyFileMetaData {
+ public:
+  // Parses the serialized FileMetaData in buf/len, which is copied. Throws
+  // ParquetException if it is corrupt.
+  LazyFileMetaData(const uint8_t* buf, uint32_t len);
+
+  // Returns the FileMetaData with all its fields except row_groups, which is empty.
+  const parquet::FileMetaData& file_metadata() const { return metadata_; }
+
+  int num_row_groups() const { return row_groups_.size(); }
+  int num_columns(int row_group) const;
+  int64_t num_rows(int row_group) const;
+  int64_t total_byte_size(int row_group) const;
+
+  // Deserializes column chunk 'column' of row group 'row_group'. Each call
+  // deserializes it again, so callers should keep the result.
+  void GetColumnChunk(int row_group, int column, parquet::ColumnChunk* chunk) const;
+
+  // Deserializes all of row group 'row_group'.
+  void GetRowGroup(int row_group, parquet::RowGroup* result) const;
+
+ private:
+  // Location of a struct in buffer_.
+  struct Range {
+    uint32_t offset;
+    uint32_t len;
+  };
+
+  struct RowGroupLocation {
+    int64_t total_byte_size;
+    int64_t num_rows;
+    std::vector<Range> columns;
+    std::vector<Range> sorting_columns;
+  };
+
+  void ParseRowGroup(CompactProtocolReader* reader, RowGroupLocation* row_group);
+
+  // Deserializes the struct at 'range' into 'msg'.
+  template <class T>
+  void Deserialize(const Range& range, T* msg) const;
+
+  // Throw ParquetException if the row group (and column) index is invalid.
+  void CheckRowGroup(int row_group) const;
+  void CheckColumn(int row_group, int column) const;
+
+  std::vector<uint8_t> buffer_;
+  parquet::FileMetaData metadata_;
+  std::vector<RowGroupLocation> row_groups_;
+};
+
+}
+
+#endif
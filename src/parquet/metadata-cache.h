@@ -0,0 +1,97 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_METADATA_CACHE_H
+#define PARQUET_METADATA_CACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "parquet/parquet.h"
+#include "parquet/schema.h"
+
+namespace parquet_cpp {
+
+// LRU cache of parsed footers: the FileMetaData and the Schema built from it. Files
+// are identified by path, size and modification time, so a rewritten file misses.
+// Entries are evicted once their estimated memory exceeds the capacity. Thread safe.
+class MetadataCache {
+ public:
+  static const int64_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+  explicit MetadataCache(int64_t capacity = DEFAULT_CAPACITY);
+
+  // The cache shared by the whole process.
+  static MetadataCache* ProcessCache();
+
+  // Looks up the file. On a hit, returns true and sets *metadata and *schema.
+  bool Lookup(const std::string& path, int64_t size, int64_t modification_time,
+      boost::shared_ptr<const parquet::FileMetaData>* metadata,
+      boost::shared_ptr<const Schema>* schema);
+
+  // Adds the file, replacing any entry for it, and evicts the least recently used
+  // entries over the capacity. Entries larger than the capacity are not added.
+  void Insert(const std::string& path, int64_t size, int64_t modification_time,
+      const boost::shared_ptr<const parquet::FileMetaData>& metadata,
+      const boost::shared_ptr<const Schema>& schema);
+
+  void Clear();
+
+  int64_t capacity() const;
+  // Evicts entries as needed to fit the new capacity.
+  void set_capacity(int64_t capacity);
+
+  // Estimated memory of the cached entries.
+  int64_t size() const;
+  int num_entries() const;
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  struct Key {
+    std::string path;
+    int64_t size;
+    int64_t modification_time;
+
+    bool operator<(const Key& other) const;
+  };
+
+  struct Entry {
+    boost::shared_ptr<const parquet::FileMetaData> metadata;
+    boost::shared_ptr<const Schema> schema;
+    int64_t size;
+    // Position in lru_.
+    std::list<Key>::iterator lru_position;
+  };
+
+  // Evicts the least recently used entries until size_ fits capacity_. Must be
+  // called with lock_ held.
+  void Evict();
+
+  mutable boost::mutex lock_;
+  int64_t capacity_;
+  int64_t size_;
+  int64_t hits_;
+  int64_t misses_;
+  std::map<Key, Entry> entries_;
+  // Keys from the most to the least recently used.
+  std::list<Key> lru_;
+};
+
+}
+
+#endif
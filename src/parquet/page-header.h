@@ -0,0 +1,36 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_PAGE_HEADER_H
+#define PARQUET_PAGE_HEADER_H
+
+#include <boost/cstdint.hpp>
+
+#include "parquet/parquet.h"
+
+namespace parquet_cpp {
+
+// Same as DeserializeThriftMsg() for a PageHeader, but parses the compact protocol
+// bytes in place with no transport, protocol or heap allocation (statistics reuse
+// the capacity of the strings in 'header', which should be reused across pages).
+// Unknown fields are skipped, as are the IndexPageHeader and DataPageHeaderV2,
+// which the reader does not support. Throws ParquetException if buf/len ends before
+// the header or a required field is missing. On return, *len is set to the length
+// of the header.
+void DeserializePageHeader(const uint8_t* buf, uint32_t* len,
+    parquet::PageHeader* header);
+
+}
+
+#endif
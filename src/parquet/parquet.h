@@ -18,7 +18,9 @@
 #include <exception>
 #include <sstream>
 #include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include "gen-cpp/parquet_constants.h"
 #include "gen-cpp/parquet_types.h"
@@ -41,12 +43,28 @@ namespace parquet_cpp {
 
 class Codec;
 class Decoder;
+class PagePipeline;
+class ThreadPool;
 
 struct ByteArray {
   uint32_t len;
   const uint8_t* ptr;
 };
 
+// Maps a parquet physical type to the C++ type its values are read as.
+template <parquet::Type::type TYPE>
+struct type_traits {
+};
+
+template <> struct type_traits<parquet::Type::BOOLEAN> { typedef bool value_type; };
+template <> struct type_traits<parquet::Type::INT32> { typedef int32_t value_type; };
+template <> struct type_traits<parquet::Type::INT64> { typedef int64_t value_type; };
+template <> struct type_traits<parquet::Type::FLOAT> { typedef float value_type; };
+template <> struct type_traits<parquet::Type::DOUBLE> { typedef double value_type; };
+template <> struct type_traits<parquet::Type::BYTE_ARRAY> {
+  typedef ByteArray value_type;
+};
+
 std::string PrintRepetitionType(const parquet::SchemaElement& e);
 std::string PrintType(const parquet::SchemaElement& e);
 
@@ -129,46 +147,103 @@ class InMemoryInputStream : public InputStream {
 };
 
 // API to read values from a single column. This is the main client facing API.
+// ColumnReader deals with the pages and the definition/repetition levels; the
+// values are read through the TypedColumnReader for the column's type. Callers
+// that only know the type at runtime use Make() and cast the result based on
+// type(), e.g. static_cast<Int32Reader*>(reader.get()).
 class ColumnReader {
  public:
   struct Config {
+    // Number of values GetValue() decodes at a time.
     int batch_size;
 
+    // If true, the GetValue() batch doubles on every refill, up to the number of
+    // values left in the page and at most max_batch_size. Long pages are then
+    // decoded with a few large decoder calls, which matters most for decoders with
+    // per-call setup (e.g. dictionary and delta).
+    bool adaptive_batch_size;
+    int max_batch_size;
+
+    // If true, page headers are deserialized by thrift (DeserializeThriftMsg())
+    // instead of DeserializePageHeader(). For debugging.
+    bool thrift_page_headers;
+
+    // If set, the pages of compressed column chunks are read ahead and
+    // decompressed on this pool, up to decompression_pages_ahead pages ahead of
+    // the page being decoded, so decompression runs on other cores while values
+    // are decoded. The pool must outlive the reader. If NULL, each page is
+    // decompressed when it is decoded.
+    ThreadPool* decompression_pool;
+    int decompression_pages_ahead;
+
     static Config DefaultConfig() {
       Config config;
       config.batch_size = 128;
+      config.adaptive_batch_size = false;
+      config.max_batch_size = 8 * 1024;
+      config.thrift_page_headers = false;
+      config.decompression_pool = NULL;
+      config.decompression_pages_ahead = 4;
       return config;
     }
   };
 
-  ColumnReader(const parquet::ColumnMetaData*,
-      const Schema::Element*, InputStream* stream);
+  // Returns a TypedColumnReader for metadata->type.
+  static boost::shared_ptr<ColumnReader> Make(const parquet::ColumnMetaData*,
+      const Schema::Element*, InputStream* stream,
+      const Config& config = Config::DefaultConfig());
 
-  ~ColumnReader();
+  virtual ~ColumnReader();
 
   const std::string& name() const { return schema_->parquet_schema().name; }
   const std::string& full_name() const { return schema_->full_name(); }
   parquet::Type::type type() const { return schema_->parquet_schema().type; }
 
+  int max_def_level() const { return max_def_level_; }
+  int max_rep_level() const { return schema_->max_rep_level(); }
+
   // Returns true if there are still values in this column.
   bool HasNext();
 
-  // Returns the next value of this type.
-  // TODO: batchify this interface.
-  bool GetBool(bool* is_null, int* def_level, int* rep_level);
-  int32_t GetInt32(bool* is_null, int* def_level, int* rep_level);
-  int64_t GetInt64(bool* is_null, int* def_level, int* rep_level);
-  float GetFloat(bool* is_null, int* def_level, int* rep_level);
-  double GetDouble(bool* is_null, int* def_level, int* rep_level);
-  ByteArray GetByteArray(bool* is_null, int* def_level, int* rep_level);
+  // Returns true if the current data page is dictionary encoded, so its values can
+  // be read as dictionary indices with TypedColumnReader::ReadBatchIndices(). Only
+  // valid after HasNext() returned true. Writers can fall back from dictionary to
+  // PLAIN pages part way through a column chunk (e.g. when the dictionary gets too
+  // big) but not the other way, so once this returns false the caller must read
+  // values with ReadBatch() for the rest of the column.
+  bool IsDictionaryPage() const;
+
+  // Skips the next 'num_rows' rows without decoding them. Data pages that are
+  // skipped entirely are not decompressed (with a decompression pool, except the
+  // ones already queued ahead before the skip); within a page the level and value
+  // decoders skip in bulk. Returns the number of rows skipped, which is less than
+  // num_rows only at the end of the column.
+  // Only supported for non-repeated columns.
+  int64_t Skip(int64_t num_rows);
 
- private:
-  bool ReadNewPage();
+ protected:
+  ColumnReader(const parquet::ColumnMetaData*,
+      const Schema::Element*, InputStream* stream, const Config& config);
+
+  // Creates the decoders for the column's type. Called at most once per column
+  // for each encoding.
+  virtual Decoder* NewPlainDecoder() = 0;
+  virtual Decoder* NewDictionaryDecoder(const uint8_t* data, int len,
+      int num_values) = 0;
+
+  // Reads the next data page (and any dictionary page before it). If 'rows_to_skip'
+  // is set, data pages with no more than *rows_to_skip rows are skipped over without
+  // being decompressed and *rows_to_skip is decremented accordingly. Returns false
+  // at the end of the column.
+  bool ReadNewPage(int64_t* rows_to_skip = NULL);
 
   // Reads the next definition and repetition level. Returns true if the value is NULL.
   bool ReadDefRepLevels(int* def_level, int* rep_level);
 
-  void BatchDecode();
+  // Reads the next 'num_levels' definition and repetition levels. The buffers are
+  // not written (and may be NULL) if the corresponding max level is 0. Returns the
+  // number of levels that have a value.
+  int ReadLevels(int num_levels, int16_t* def_levels, int16_t* rep_levels);
 
   Config config_;
 
@@ -183,6 +258,10 @@ class ColumnReader {
   boost::scoped_ptr<Codec> decompressor_;
   std::vector<uint8_t> decompression_buffer_;
 
+  // Set if pages are decompressed ahead (Config::decompression_pool). It then
+  // reads the stream and decompressor_ is not used.
+  boost::scoped_ptr<PagePipeline> page_pipeline_;
+
   // Map of compression type to decompressor object.
   boost::unordered_map<parquet::Encoding::type, boost::shared_ptr<Decoder> > decoders_;
 
@@ -195,61 +274,120 @@ class ColumnReader {
   Decoder* current_decoder_;
   int num_buffered_values_;
 
-  std::vector<uint8_t> values_buffer_;
+  // Number of values the typed reader has decoded ahead into its values buffer and
+  // how many of those have been returned. Reset on every new data page.
   int num_decoded_values_;
   int buffered_values_offset_;
 };
 
+// Reader for a column with physical type TYPE. The value reading functions are
+// only defined here, so the decode loop for a column is compiled for its concrete
+// value type, with no switch on the column type and no untyped value buffers. The
+// decoder is called once per batch.
+template <parquet::Type::type TYPE>
+class TypedColumnReader : public ColumnReader {
+ public:
+  typedef typename type_traits<TYPE>::value_type T;
+
+  TypedColumnReader(const parquet::ColumnMetaData* metadata,
+      const Schema::Element* schema, InputStream* stream,
+      const Config& config = Config::DefaultConfig());
+
+  // Reads up to 'batch_size' definition and repetition levels and the non-null
+  // values they describe, decoding directly into the caller's buffers. The levels
+  // are returned for every entry (including NULLs) but 'values' is dense: only
+  // entries with def_level == max_def_level() have a value.
+  // def_levels and rep_levels must have room for batch_size entries and may be NULL
+  // if max_def_level() or max_rep_level() is 0 respectively (they are not written
+  // in that case). 'values' must have room for batch_size values.
+  // Returns the number of levels read and sets *values_read to the number of
+  // values written. A batch never spans data pages, so the result can be less than
+  // batch_size even when there is more data; call HasNext() to check for that.
+  int64_t ReadBatch(int batch_size, int16_t* def_levels, int16_t* rep_levels,
+      T* values, int64_t* values_read);
+
+  // Like ReadBatch() but returns the values without copying them into a caller
+  // buffer: *values is set to point at the *values_read dense values. For PLAIN
+  // pages of fixed width types this points straight into the (decompressed) page
+  // data; otherwise the values are decoded into a buffer owned by the reader. Either
+  // way the values are only valid until the next call to a read function on this
+  // reader.
+  int64_t ReadBatchZeroCopy(int batch_size, int16_t* def_levels, int16_t* rep_levels,
+      const T** values, int64_t* values_read);
+
+  // Like ReadBatch() but leaves a slot in 'values' for every level read, so value i
+  // belongs to level i. Bit 'valid_bits_offset + i' of 'valid_bits' (LSB first) is
+  // set if slot i holds a value and cleared if it is NULL; the contents of NULL slots
+  // are undefined. This lets callers append batches straight into a columnar vector
+  // and its null bitmap. Other bits of 'valid_bits' are not modified.
+  // Only supported for non-repeated columns, where each level is a row.
+  // Returns the number of levels (slots) read and sets *null_count to the number of
+  // NULLs among them.
+  int64_t ReadBatchSpaced(int batch_size, int16_t* def_levels, T* values,
+      uint8_t* valid_bits, int64_t valid_bits_offset, int64_t* null_count);
+
+  // Like ReadBatch() but returns the values as indices into dictionary() instead of
+  // looking them up, so callers can group, join or filter on the indices and only
+  // materialize the values they need. Must only be called when IsDictionaryPage()
+  // is true, and not after GetValue() in the same page.
+  int64_t ReadBatchIndices(int batch_size, int16_t* def_levels, int16_t* rep_levels,
+      int32_t* indices, int64_t* indices_read);
+
+  // Returns the column chunk's dictionary, or NULL if it has none. The dictionary is
+  // read with the first data page (i.e. by HasNext()) and stays valid for the life
+  // of the reader. For BYTE_ARRAY columns the values point to memory owned by the
+  // reader.
+  const std::vector<T>* dictionary() const;
+
+  // Returns the next value, one at a time. Values are decoded in batches (see
+  // Config) behind the scenes but ReadBatch() avoids the per-value overhead.
+  T GetValue(bool* is_null, int* def_level, int* rep_level);
+
+  // Number of values the next GetValue() refill decodes: Config::batch_size, or
+  // more once Config::adaptive_batch_size has grown it.
+  int batch_size() const { return batch_size_; }
 
-inline bool ColumnReader::HasNext() {
-  if (num_buffered_values_ == 0) {
-    ReadNewPage();
-    if (num_buffered_values_ == 0) return false;
-  }
-  return true;
-}
+ private:
+  virtual Decoder* NewPlainDecoder();
+  virtual Decoder* NewDictionaryDecoder(const uint8_t* data, int len, int num_values);
 
-inline bool ColumnReader::GetBool(bool* is_null, int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return bool();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<bool*>(&values_buffer_[0])[buffered_values_offset_++];
-}
+  // Decodes the next batch_size_ values into values_buffer_, growing the batch
+  // first in adaptive mode.
+  void BatchDecode();
 
-inline int32_t ColumnReader::GetInt32(bool* is_null, int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return int32_t();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<int32_t*>(&values_buffer_[0])[buffered_values_offset_++];
-}
+  // Decodes the next 'num_values' values into 'values', starting with any values
+  // still buffered in values_buffer_ by GetValue(). Returns the number of values
+  // decoded.
+  int DecodeValues(T* values, int num_values);
 
-inline int64_t ColumnReader::GetInt64(bool* is_null, int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return int64_t();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<int64_t*>(&values_buffer_[0])[buffered_values_offset_++];
-}
+  // Returns a pointer to the next 'num_values' values in the current page, without
+  // decoding them, if the page allows it. Returns NULL otherwise.
+  const T* DecodeInPlace(int num_values);
 
-inline float ColumnReader::GetFloat(bool* is_null, int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return float();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<float*>(&values_buffer_[0])[buffered_values_offset_++];
-}
+  // Values decoded ahead for GetValue(). values_buffer_size_ is its capacity and
+  // batch_size_ the number of values the next BatchDecode() decodes.
+  boost::scoped_array<T> values_buffer_;
+  int values_buffer_size_;
+  int batch_size_;
 
-inline double ColumnReader::GetDouble(bool* is_null, int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return double();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<double*>(&values_buffer_[0])[buffered_values_offset_++];
-}
+  // Values returned by ReadBatchZeroCopy() when they cannot point into the page.
+  boost::scoped_array<T> scratch_buffer_;
+  int scratch_buffer_size_;
+};
 
-inline ByteArray ColumnReader::GetByteArray(bool* is_null,
-    int* def_level, int* rep_level) {
-  *is_null = ReadDefRepLevels(def_level, rep_level);
-  if (*is_null) return ByteArray();
-  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
-  return reinterpret_cast<ByteArray*>(&values_buffer_[0])[buffered_values_offset_++];
+typedef TypedColumnReader<parquet::Type::BOOLEAN> BoolReader;
+typedef TypedColumnReader<parquet::Type::INT32> Int32Reader;
+typedef TypedColumnReader<parquet::Type::INT64> Int64Reader;
+typedef TypedColumnReader<parquet::Type::FLOAT> FloatReader;
+typedef TypedColumnReader<parquet::Type::DOUBLE> DoubleReader;
+typedef TypedColumnReader<parquet::Type::BYTE_ARRAY> ByteArrayReader;
+
+inline bool ColumnReader::HasNext() {
+  if (num_buffered_values_ == 0) {
+    ReadNewPage();
+    if (num_buffered_values_ == 0) return false;
+  }
+  return true;
 }
 
 inline bool ColumnReader::ReadDefRepLevels(int* def_level, int* rep_level) {
@@ -266,27 +404,67 @@ inline bool ColumnReader::ReadDefRepLevels(int* def_level, int* rep_level) {
   return *def_level != max_def_level_;
 }
 
-// Deserialize a thrift message from buf/len.  buf/len must at least contain
-// all the bytes needed to store the thrift message.  On return, len will be
-// set to the actual length of the header.
+template <parquet::Type::type TYPE>
+inline typename TypedColumnReader<TYPE>::T TypedColumnReader<TYPE>::GetValue(
+    bool* is_null, int* def_level, int* rep_level) {
+  *is_null = ReadDefRepLevels(def_level, rep_level);
+  if (*is_null) return T();
+  if (buffered_values_offset_ == num_decoded_values_) BatchDecode();
+  return values_buffer_[buffered_values_offset_++];
+}
+
+// Deserializes thrift messages with one memory transport and compact protocol,
+// which are reset over the bytes of each message instead of being created for every
+// message. Not thread safe; DeserializeThriftMsg() uses one per thread.
+class ThriftDeserializer {
+ public:
+  ThriftDeserializer();
+
+  // Deserialize a thrift message from buf/len. buf/len must at least contain all
+  // the bytes needed to store the thrift message. On return, len will be set to the
+  // actual length of the message.
+  template <class T>
+  void Deserialize(const uint8_t* buf, uint32_t* len, T* deserialized_msg);
+
+  // Returns the deserializer of the calling thread.
+  static ThriftDeserializer* ThreadLocal();
+
+ private:
+  // Creates a new protocol, dropping any state a failed read left in the old one.
+  void ResetProtocol();
+
+  boost::shared_ptr<apache::thrift::transport::TMemoryBuffer> transport_;
+  boost::scoped_ptr<apache::thrift::protocol::TCompactProtocolT<
+      apache::thrift::transport::TMemoryBuffer> > protocol_;
+};
+
 template <class T>
-inline void DeserializeThriftMsg(const uint8_t* buf, uint32_t* len, T* deserialized_msg) {
-  // Deserialize msg bytes into c++ thrift msg using memory transport.
-  boost::shared_ptr<apache::thrift::transport::TMemoryBuffer> tmem_transport(
-      new apache::thrift::transport::TMemoryBuffer(const_cast<uint8_t*>(buf), *len));
-  apache::thrift::protocol::TCompactProtocolFactoryT<
-      apache::thrift::transport::TMemoryBuffer> tproto_factory;
-  boost::shared_ptr<apache::thrift::protocol::TProtocol> tproto =
-      tproto_factory.getProtocol(tmem_transport);
+inline void ThriftDeserializer::Deserialize(const uint8_t* buf, uint32_t* len,
+    T* deserialized_msg) {
+  // The transport reads the caller's bytes in place.
+  transport_->resetBuffer(const_cast<uint8_t*>(buf), *len);
   try {
-    deserialized_msg->read(tproto.get());
+    deserialized_msg->read(protocol_.get());
   } catch (apache::thrift::protocol::TProtocolException& e) {
+    ResetProtocol();
+    throw ParquetException("Couldn't deserialize thrift.", e);
+  } catch (apache::thrift::transport::TTransportException& e) {
+    // The message is longer than 'len'.
+    ResetProtocol();
     throw ParquetException("Couldn't deserialize thrift.", e);
   }
-  uint32_t bytes_left = tmem_transport->available_read();
+  uint32_t bytes_left = transport_->available_read();
   *len = *len - bytes_left;
 }
 
+// Deserialize a thrift message from buf/len.  buf/len must at least contain
+// all the bytes needed to store the thrift message.  On return, len will be
+// set to the actual length of the header.
+template <class T>
+inline void DeserializeThriftMsg(const uint8_t* buf, uint32_t* len, T* deserialized_msg) {
+  ThriftDeserializer::ThreadLocal()->Deserialize(buf, len, deserialized_msg);
+}
+
 }
 
 #endif
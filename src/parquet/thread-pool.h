@@ -0,0 +1,58 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARQUET_THREAD_POOL_H
+#define PARQUET_THREAD_POOL_H
+
+#include <deque>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace parquet_cpp {
+
+// Fixed number of threads that run the submitted tasks in submission order. Tasks
+// must not throw; exceptions that escape them are dropped. Thread safe.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+
+  // Runs the tasks still queued, then stops the threads.
+  ~ThreadPool();
+
+  void Submit(const boost::function<void()>& task);
+
+  int num_threads() const { return num_threads_; }
+
+  // Number of tasks submitted so far.
+  int64_t num_tasks_submitted();
+
+ private:
+  // Body of each thread: runs tasks until the pool is shut down and the queue is
+  // empty.
+  void WorkerLoop();
+
+  const int num_threads_;
+  boost::mutex lock_;
+  // Signalled when a task is queued or the pool is shut down.
+  boost::condition_variable task_ready_;
+  std::deque<boost::function<void()> > tasks_;
+  int64_t num_tasks_submitted_;
+  bool shutdown_;
+  boost::thread_group threads_;
+};
+
+}
+
+#endif
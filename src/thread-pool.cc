@@ -0,0 +1,72 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parquet/thread-pool.h"
+#include "parquet/parquet.h"
+
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace parquet_cpp {
+
+ThreadPool::ThreadPool(int num_threads)
+  : num_threads_(num_threads), num_tasks_submitted_(0), shutdown_(false) {
+  if (num_threads <= 0) throw ParquetException("Invalid number of threads.");
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.create_thread(boost::bind(&ThreadPool::WorkerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    boost::lock_guard<boost::mutex> l(lock_);
+    shutdown_ = true;
+  }
+  task_ready_.notify_all();
+  threads_.join_all();
+}
+
+void ThreadPool::Submit(const boost::function<void()>& task) {
+  {
+    boost::lock_guard<boost::mutex> l(lock_);
+    tasks_.push_back(task);
+    ++num_tasks_submitted_;
+  }
+  task_ready_.notify_one();
+}
+
+int64_t ThreadPool::num_tasks_submitted() {
+  boost::lock_guard<boost::mutex> l(lock_);
+  return num_tasks_submitted_;
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    boost::function<void()> task;
+    {
+      boost::unique_lock<boost::mutex> l(lock_);
+      while (tasks_.empty() && !shutdown_) task_ready_.wait(l);
+      if (tasks_.empty()) return;
+      task = tasks_.front();
+      tasks_.pop_front();
+    }
+    try {
+      task();
+    } catch (...) {
+    }
+  }
+}
+
+}
@@ -0,0 +1,109 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "impala/bit-packing.h"
+#include "impala/cpu-info.h"
+#include "impala/bit-stream-utils.inline.h"
+
+using namespace impala;
+using namespace std;
+
+const int MAX_WIDTH = 32;
+
+typedef const uint8_t* (*UnpackFn)(const uint8_t* in, uint32_t* out, int num_bits);
+
+// Packs 'num_values' random values of 'num_bits' into a buffer sized exactly for them.
+static vector<uint8_t> PackRandom(int num_bits, int num_values, vector<uint32_t>* values) {
+  vector<uint8_t> buffer(num_bits * num_values / 8);
+  BitWriter writer(buffer.empty() ? NULL : &buffer[0], buffer.size());
+  uint64_t mask = (1ULL << num_bits) - 1;
+  for (int i = 0; i < num_values; ++i) {
+    uint32_t value = (static_cast<uint64_t>(rand()) << 16 ^ rand()) & mask;
+    values->push_back(value);
+    EXPECT_TRUE(writer.PutValue(value, num_bits));
+  }
+  writer.Flush();
+  return buffer;
+}
+
+static void TestUnpack(UnpackFn fn) {
+  srand(0);
+  for (int num_bits = 0; num_bits <= MAX_WIDTH; ++num_bits) {
+    vector<uint32_t> values;
+    // Pack into a heap buffer of the exact size so reads past it are caught by
+    // tools like valgrind and ASAN.
+    vector<uint8_t> packed = PackRandom(num_bits, 64, &values);
+    const uint8_t* in = packed.empty() ? NULL : &packed[0];
+    for (int group = 0; group < 2; ++group) {
+      uint32_t out[32];
+      const uint8_t* next = fn(in, out, num_bits);
+      EXPECT_EQ(next - in, 4 * num_bits);
+      for (int i = 0; i < 32; ++i) {
+        EXPECT_EQ(out[i], values[group * 32 + i]) << "num_bits = " << num_bits;
+      }
+      in = next;
+    }
+  }
+}
+
+TEST(BitPacking, Unpack32Scalar) {
+  TestUnpack(BitPacking::Unpack32Scalar);
+}
+
+TEST(BitPacking, Unpack32Sse) {
+  TestUnpack(BitPacking::Unpack32Sse);
+}
+
+TEST(BitPacking, Unpack32Avx2) {
+  if (!CpuInfo::SupportsAvx2()) return;
+  TestUnpack(BitPacking::Unpack32Avx2);
+}
+
+TEST(BitPacking, Unpack32) {
+  TestUnpack(BitPacking::Unpack32);
+}
+
+// Reading a batch that starts mid byte unpacks single values up to a byte boundary
+// and then 32 at a time.
+TEST(BitPacking, UnalignedBatch) {
+  srand(0);
+  for (int num_bits = 1; num_bits <= MAX_WIDTH; ++num_bits) {
+    vector<uint32_t> values;
+    vector<uint8_t> packed = PackRandom(num_bits, 200, &values);
+    BitReader reader(&packed[0], packed.size());
+
+    int16_t first = 0;
+    int64_t rest[199];
+    EXPECT_TRUE(reader.GetValue(1, &first));
+    EXPECT_EQ(first, values[0] & 1);
+    // Skip the rest of the first value.
+    if (num_bits > 1) reader.SkipBits(num_bits - 1);
+    EXPECT_EQ(reader.GetBatch(num_bits, rest, 199), 199);
+    for (int i = 0; i < 199; ++i) {
+      EXPECT_EQ(rest[i], values[i + 1]) << "num_bits = " << num_bits;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
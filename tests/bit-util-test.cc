@@ -88,6 +88,27 @@ TEST(BitUtil, Log2) {
   EXPECT_EQ(BitUtil::Log2(ULLONG_MAX), 64);
 }
 
+TEST(BitUtil, Bitmap) {
+  EXPECT_EQ(BitUtil::BytesForBits(0), 0);
+  EXPECT_EQ(BitUtil::BytesForBits(1), 1);
+  EXPECT_EQ(BitUtil::BytesForBits(8), 1);
+  EXPECT_EQ(BitUtil::BytesForBits(9), 2);
+
+  uint8_t bits[2] = { 0, 0 };
+  BitUtil::SetBit(bits, 0);
+  BitUtil::SetBit(bits, 3);
+  BitUtil::SetBit(bits, 9);
+  EXPECT_EQ(bits[0], BOOST_BINARY(0 0 0 0 1 0 0 1));
+  EXPECT_EQ(bits[1], BOOST_BINARY(0 0 0 0 0 0 1 0));
+  EXPECT_TRUE(BitUtil::GetBit(bits, 3));
+  EXPECT_FALSE(BitUtil::GetBit(bits, 4));
+  EXPECT_TRUE(BitUtil::GetBit(bits, 9));
+
+  BitUtil::ClearBit(bits, 3);
+  EXPECT_FALSE(BitUtil::GetBit(bits, 3));
+  EXPECT_EQ(bits[0], 1);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
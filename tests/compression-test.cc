@@ -0,0 +1,198 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "compression/codec.h"
+
+using namespace parquet;
+using namespace parquet_cpp;
+using namespace std;
+
+// Compresses and decompresses 'data' with 'codec' and checks the result.
+static void TestRoundTrip(Codec* codec, const vector<uint8_t>& data) {
+  const uint8_t* input = data.empty() ? NULL : &data[0];
+  vector<uint8_t> compressed(codec->MaxCompressedLen(data.size(), input));
+  int compressed_len = codec->Compress(data.size(), input, compressed.size(),
+      &compressed[0]);
+  EXPECT_GT(compressed_len, 0);
+  EXPECT_LE(compressed_len, compressed.size());
+
+  vector<uint8_t> decompressed(data.size() + 1);
+  codec->Decompress(compressed_len, &compressed[0], data.size(), &decompressed[0]);
+  EXPECT_EQ(memcmp(&decompressed[0], input, data.size()), 0);
+}
+
+// Runs the round trip on compressible and random data of a few sizes.
+static void TestCodec(Codec* codec) {
+  for (int len = 1; len <= 1024 * 1024; len *= 32) {
+    vector<uint8_t> data(len);
+    for (int i = 0; i < len; ++i) data[i] = i % 7;
+    TestRoundTrip(codec, data);
+    for (int i = 0; i < len; ++i) data[i] = rand();
+    TestRoundTrip(codec, data);
+  }
+}
+
+TEST(Codec, Create) {
+  EXPECT_TRUE(Codec::Create(CompressionCodec::UNCOMPRESSED) == NULL);
+  boost::scoped_ptr<Codec> snappy(Codec::Create(CompressionCodec::SNAPPY));
+  EXPECT_STREQ(snappy->name(), "snappy");
+  boost::scoped_ptr<Codec> lz4(Codec::Create(CompressionCodec::LZ4));
+  EXPECT_STREQ(lz4->name(), "lz4");
+  boost::scoped_ptr<Codec> gzip(Codec::Create(CompressionCodec::GZIP));
+  EXPECT_STREQ(gzip->name(), "gzip");
+  boost::scoped_ptr<Codec> zstd(Codec::Create(CompressionCodec::ZSTD));
+  EXPECT_STREQ(zstd->name(), "zstd");
+  EXPECT_THROW(Codec::Create(CompressionCodec::LZO), ParquetException);
+  EXPECT_THROW(Codec::Create(static_cast<CompressionCodec::type>(100)),
+      ParquetException);
+}
+
+TEST(Codec, Snappy) {
+  SnappyCodec codec;
+  TestCodec(&codec);
+}
+
+TEST(Codec, Lz4) {
+  Lz4Codec codec;
+  TestCodec(&codec);
+
+  // Corrupt or truncated input, or the wrong output length, are errors rather than
+  // reads or writes past the buffers.
+  vector<uint8_t> data(64 * 1024);
+  for (int i = 0; i < data.size(); ++i) data[i] = i % 13;
+  vector<uint8_t> compressed(codec.MaxCompressedLen(data.size(), &data[0]));
+  int compressed_len = codec.Compress(data.size(), &data[0], compressed.size(),
+      &compressed[0]);
+  vector<uint8_t> output(data.size());
+  EXPECT_THROW(codec.Decompress(compressed_len / 2, &compressed[0], output.size(),
+      &output[0]), ParquetException);
+  EXPECT_THROW(codec.Decompress(compressed_len, &compressed[0], output.size() / 2,
+      &output[0]), ParquetException);
+}
+
+// Compresses 'data' the way Hadoop's Lz4Codec does: frames of at most
+// 'frame_size' bytes, each a big endian decompressed size, a big endian compressed
+// size and a raw LZ4 block.
+static vector<uint8_t> HadoopLz4Frames(Lz4Codec* codec, const vector<uint8_t>& data,
+    int frame_size) {
+  vector<uint8_t> result;
+  for (int offset = 0; offset < data.size(); offset += frame_size) {
+    int len = ::min<int>(frame_size, data.size() - offset);
+    vector<uint8_t> block(codec->MaxCompressedLen(len, &data[offset]));
+    block.resize(codec->Compress(len, &data[offset], block.size(), &block[0]));
+    uint32_t sizes[] = { static_cast<uint32_t>(len),
+        static_cast<uint32_t>(block.size()) };
+    for (int i = 0; i < 2; ++i) {
+      for (int shift = 24; shift >= 0; shift -= 8) {
+        result.push_back(static_cast<uint8_t>(sizes[i] >> shift));
+      }
+    }
+    result.insert(result.end(), block.begin(), block.end());
+  }
+  return result;
+}
+
+TEST(Codec, Lz4HadoopFrames) {
+  Lz4Codec codec;
+  vector<uint8_t> data(100 * 1000);
+  for (int i = 0; i < data.size(); ++i) data[i] = i % 11;
+  // One frame and several, the last one short.
+  for (int frame_size = data.size(); frame_size >= 30 * 1000; frame_size /= 3) {
+    vector<uint8_t> framed = HadoopLz4Frames(&codec, data, frame_size);
+    vector<uint8_t> output(data.size());
+    codec.Decompress(framed.size(), &framed[0], output.size(), &output[0]);
+    EXPECT_TRUE(output == data);
+    // Truncated frames are not mistaken for raw blocks.
+    EXPECT_THROW(codec.Decompress(framed.size() - 1, &framed[0], output.size(),
+        &output[0]), ParquetException);
+    EXPECT_THROW(codec.Decompress(framed.size(), &framed[0], output.size() - 1,
+        &output[0]), ParquetException);
+  }
+}
+
+TEST(Codec, Gzip) {
+  // The same codec is reused for every page.
+  GzipCodec codec;
+  TestCodec(&codec);
+
+  vector<uint8_t> data(64 * 1024);
+  for (int i = 0; i < data.size(); ++i) data[i] = i % 13;
+  vector<uint8_t> compressed(codec.MaxCompressedLen(data.size(), &data[0]));
+  int compressed_len = codec.Compress(data.size(), &data[0], compressed.size(),
+      &compressed[0]);
+  // gzip header.
+  EXPECT_EQ(compressed[0], 0x1f);
+  EXPECT_EQ(compressed[1], 0x8b);
+  vector<uint8_t> output(data.size());
+  EXPECT_THROW(codec.Decompress(compressed_len / 2, &compressed[0], output.size(),
+      &output[0]), ParquetException);
+  EXPECT_THROW(codec.Decompress(compressed_len, &compressed[0], output.size() / 2,
+      &output[0]), ParquetException);
+  // A failed page does not break the next one.
+  codec.Decompress(compressed_len, &compressed[0], output.size(), &output[0]);
+  EXPECT_EQ(output, data);
+
+  EXPECT_THROW(codec.Compress(data.size(), &data[0], 10, &compressed[0]),
+      ParquetException);
+}
+
+TEST(Codec, Zstd) {
+  ZstdCodec codec;
+  EXPECT_EQ(codec.compression_level(), ZstdCodec::DEFAULT_COMPRESSION_LEVEL);
+  TestCodec(&codec);
+  EXPECT_THROW(ZstdCodec(0), ParquetException);
+  EXPECT_THROW(ZstdCodec(100), ParquetException);
+
+  vector<uint8_t> data(64 * 1024);
+  for (int i = 0; i < data.size(); ++i) data[i] = i % 13;
+  vector<uint8_t> compressed(codec.MaxCompressedLen(data.size(), &data[0]));
+  int compressed_len = codec.Compress(data.size(), &data[0], compressed.size(),
+      &compressed[0]);
+
+  // Higher levels write data that any level reads back.
+  ZstdCodec high_codec(9);
+  TestCodec(&high_codec);
+  vector<uint8_t> high_compressed(compressed.size());
+  int high_compressed_len = high_codec.Compress(data.size(), &data[0],
+      high_compressed.size(), &high_compressed[0]);
+  EXPECT_LE(high_compressed_len, compressed_len);
+  vector<uint8_t> output(data.size());
+  codec.Decompress(high_compressed_len, &high_compressed[0], output.size(),
+      &output[0]);
+  EXPECT_EQ(output, data);
+
+  EXPECT_THROW(codec.Decompress(compressed_len / 2, &compressed[0], output.size(),
+      &output[0]), ParquetException);
+  EXPECT_THROW(codec.Decompress(compressed_len, &compressed[0], output.size() / 2,
+      &output[0]), ParquetException);
+  // A failed page does not break the next one.
+  codec.Decompress(compressed_len, &compressed[0], output.size(), &output[0]);
+  EXPECT_EQ(output, data);
+
+  EXPECT_THROW(codec.Compress(data.size(), &data[0], 10, &compressed[0]),
+      ParquetException);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -93,6 +93,25 @@ void TestValues(Encoder* e, Decoder* d, const string* values, int num) {
   }
 }
 
+// Encodes 'values', skips the first 'num_skip' and checks the rest decode correctly.
+template<typename T>
+void TestSkip(Encoder* e, Decoder* d, const T* values, int num, int num_skip) {
+  e->Reset();
+  EXPECT_EQ(e->Add(values, num), num);
+  int encoded_len = 0;
+  const uint8_t* encoded = e->Encode(&encoded_len);
+
+  d->SetData(num, encoded, encoded_len);
+  EXPECT_EQ(d->Skip(num_skip), num_skip);
+  EXPECT_EQ(d->values_left(), num - num_skip);
+  T decoded[num];
+  int n = d->Get(decoded, num);
+  EXPECT_EQ(n, num - num_skip);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(decoded[i], values[num_skip + i]) << i;
+  }
+}
+
 template<typename T>
 void TestAllEncodings(Type::type t, const T* values, int num) {
   const vector<EncodeDecode>& ed = all_encodings[t];
@@ -113,6 +132,31 @@ TEST(Encoder, BasicTest) {
   TestAllEncodings(Type::DOUBLE, double_values, sizeof(double_values) / sizeof(double));
 }
 
+// INT64 deltas can need more than 32 bits, which the unpacking kernels don't handle.
+TEST(DeltaBitPackDecoder, WideInt64Deltas) {
+  const int N = 1000;
+  int64_t values[N];
+  srand(0);
+  values[0] = 0;
+  for (int i = 1; i < N; ++i) {
+    values[i] = values[i - 1] + (static_cast<int64_t>(rand() % 1000) << 30) - 1000;
+  }
+  // Large mini blocks so the deltas are read in batches of 32 or more.
+  DeltaBitPackEncoder encoder(Type::INT64, BUFFER_SIZE, 64);
+  DeltaBitPackDecoder decoder(Type::INT64);
+  TestValues(&encoder, &decoder, values, N);
+
+  // An INT32 column can't have deltas that wide.
+  encoder.Reset();
+  encoder.Add(values, N);
+  int encoded_len = 0;
+  const uint8_t* encoded = encoder.Encode(&encoded_len);
+  DeltaBitPackDecoder int32_decoder(Type::INT32);
+  int32_decoder.SetData(N, encoded, encoded_len);
+  int32_t decoded[N];
+  EXPECT_THROW(int32_decoder.Get(decoded, N), ParquetException);
+}
+
 TEST(BoolEncoder, Basic) {
   scoped_ptr<BoolEncoder> e(new BoolEncoder(BUFFER_SIZE));
   scoped_ptr<BoolDecoder> d(new BoolDecoder());
@@ -156,6 +200,131 @@ TEST(BoolEncoder, Basic) {
   }
 }
 
+// PLAIN booleans are bit packed, LSB first. Reads that start and end part way
+// through a byte.
+TEST(BoolDecoder, Unaligned) {
+  uint8_t data[] = { 0xa5, 0x3c, 0x0f };
+  const int N = 21;
+  BoolDecoder decoder;
+  decoder.SetData(N, data, sizeof(data));
+  int sizes[] = { 3, 7, 1, 10 };
+  int pos = 0;
+  bool values[10];
+  for (int i = 0; i < sizeof(sizes) / sizeof(int); ++i) {
+    EXPECT_EQ(decoder.Get(values, sizes[i]), sizes[i]);
+    for (int j = 0; j < sizes[i]; ++j, ++pos) {
+      EXPECT_EQ(values[j], (data[pos / 8] >> (pos % 8)) & 1) << pos;
+    }
+  }
+  EXPECT_EQ(decoder.Get(values, 10), 0);
+
+  decoder.SetData(N, data, sizeof(data));
+  EXPECT_EQ(decoder.Skip(5), 5);
+  EXPECT_EQ(decoder.Get(values, 4), 4);
+  for (int j = 0; j < 4; ++j) {
+    EXPECT_EQ(values[j], (data[(5 + j) / 8] >> ((5 + j) % 8)) & 1) << j;
+  }
+
+  // Round trip of a count that is not a multiple of 8.
+  BoolEncoder encoder(BUFFER_SIZE);
+  bool odd_values[13];
+  for (int i = 0; i < 13; ++i) odd_values[i] = i % 3 == 1;
+  TestValues(&encoder, &decoder, odd_values, 13);
+}
+
+TEST(Decoder, Skip) {
+  const int N = 1000;
+  bool bool_values[N];
+  int64_t i64_values[N];
+  for (int i = 0; i < N; ++i) {
+    bool_values[i] = i % 3 == 0;
+    i64_values[i] = i * 7;
+  }
+
+  BoolEncoder bool_encoder(BUFFER_SIZE);
+  BoolDecoder bool_decoder;
+  PlainEncoder plain_encoder(Type::INT64, BUFFER_SIZE);
+  PlainDecoder<Type::INT64> plain_decoder;
+  int skips[] = { 0, 1, 7, 64, 65, 999, 1000 };
+  for (int i = 0; i < sizeof(skips) / sizeof(int); ++i) {
+    TestSkip(&bool_encoder, &bool_decoder, bool_values, N, skips[i]);
+    TestSkip(&plain_encoder, &plain_decoder, i64_values, N, skips[i]);
+  }
+
+  // Skipping past the end of the page stops at the end.
+  plain_encoder.Reset();
+  plain_encoder.Add(i64_values, 10);
+  int encoded_len = 0;
+  const uint8_t* encoded = plain_encoder.Encode(&encoded_len);
+  plain_decoder.SetData(10, encoded, encoded_len);
+  EXPECT_EQ(plain_decoder.Skip(20), 10);
+}
+
+TEST(PlainDecoder, GetInPlace) {
+  int64_t values[] = { 1, 2, 3, 4, 5 };
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(values);
+  PlainDecoder<Type::INT64> decoder;
+  decoder.SetData(5, data, sizeof(values));
+
+  const int64_t* result = decoder.GetInPlace(2);
+  EXPECT_EQ(result, values);
+  result = decoder.GetInPlace(2);
+  EXPECT_EQ(result, values + 2);
+  EXPECT_EQ(decoder.values_left(), 1);
+  // Not enough values left.
+  EXPECT_TRUE(decoder.GetInPlace(2) == NULL);
+  EXPECT_EQ(decoder.values_left(), 1);
+  int64_t v;
+  EXPECT_EQ(decoder.Get(&v, 1), 1);
+  EXPECT_EQ(v, 5);
+
+  // Misaligned data must be copied out.
+  int64_t storage[6];
+  uint8_t* misaligned = reinterpret_cast<uint8_t*>(storage) + 1;
+  memcpy(misaligned, values, sizeof(values));
+  decoder.SetData(5, misaligned, sizeof(values));
+  EXPECT_TRUE(decoder.GetInPlace(1) == NULL);
+  EXPECT_EQ(decoder.Get(&v, 1), 1);
+  EXPECT_EQ(v, 1);
+}
+
+TEST(DictionaryDecoder, GetIndices) {
+  int64_t dict_values[] = { 100, 200, 300, 400 };
+  PlainEncoder dict_encoder(Type::INT64, BUFFER_SIZE);
+  dict_encoder.Add(dict_values, 4);
+  int dict_len = 0;
+  const uint8_t* dict_data = dict_encoder.Encode(&dict_len);
+  PlainDecoder<Type::INT64> dict_decoder;
+  dict_decoder.SetData(4, dict_data, dict_len);
+  DictionaryDecoder<Type::INT64> decoder(&dict_decoder);
+  EXPECT_EQ(decoder.dictionary().size(), 4);
+  EXPECT_EQ(decoder.dictionary()[2], 300);
+
+  // A data page is the index bit width followed by the RLE encoded indices.
+  const int N = 100;
+  uint8_t page[1024];
+  page[0] = 2;
+  RleEncoder idx_encoder(page + 1, sizeof(page) - 1, 2);
+  for (int i = 0; i < N; ++i) EXPECT_TRUE(idx_encoder.Put(i % 7 % 4));
+  int page_len = idx_encoder.Flush() + 1;
+
+  decoder.SetData(N, page, page_len);
+  int32_t indices[N];
+  EXPECT_EQ(decoder.GetIndices(indices, 10), 10);
+  int64_t values[N];
+  EXPECT_EQ(decoder.Get(values + 10, N), N - 10);
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(indices[i], i % 7 % 4);
+  for (int i = 10; i < N; ++i) EXPECT_EQ(values[i], dict_values[i % 7 % 4]);
+
+  // Indices past the dictionary are rejected.
+  page[0] = 3;
+  RleEncoder bad_encoder(page + 1, sizeof(page) - 1, 3);
+  for (int i = 0; i < N; ++i) EXPECT_TRUE(bad_encoder.Put(i % 6));
+  page_len = bad_encoder.Flush() + 1;
+  decoder.SetData(N, page, page_len);
+  EXPECT_THROW(decoder.GetIndices(indices, N), ParquetException);
+}
+
 TEST(StringEncoder, Basic) {
   vector<string> values;
   // Wikipedia example
@@ -179,26 +348,26 @@ void InitEncodings() {
       new BoolEncoder(BUFFER_SIZE), new BoolDecoder));
 
   all_encodings[Type::INT32].push_back(EncodeDecode(
-      new PlainEncoder(Type::INT32, BUFFER_SIZE), new PlainDecoder(Type::INT32)));
+      new PlainEncoder(Type::INT32, BUFFER_SIZE), new PlainDecoder<Type::INT32>()));
   all_encodings[Type::INT32].push_back(EncodeDecode(
       new DeltaBitPackEncoder(Type::INT32, BUFFER_SIZE),
       new DeltaBitPackDecoder(Type::INT32)));
 
   all_encodings[Type::INT64].push_back(EncodeDecode(
-      new PlainEncoder(Type::INT64, BUFFER_SIZE), new PlainDecoder(Type::INT64)));
+      new PlainEncoder(Type::INT64, BUFFER_SIZE), new PlainDecoder<Type::INT64>()));
   all_encodings[Type::INT64].push_back(EncodeDecode(
       new DeltaBitPackEncoder(Type::INT64, BUFFER_SIZE),
       new DeltaBitPackDecoder(Type::INT64)));
 
   all_encodings[Type::FLOAT].push_back(EncodeDecode(
-      new PlainEncoder(Type::FLOAT, BUFFER_SIZE), new PlainDecoder(Type::FLOAT)));
+      new PlainEncoder(Type::FLOAT, BUFFER_SIZE), new PlainDecoder<Type::FLOAT>()));
 
   all_encodings[Type::DOUBLE].push_back(EncodeDecode(
-      new PlainEncoder(Type::DOUBLE, BUFFER_SIZE), new PlainDecoder(Type::DOUBLE)));
+      new PlainEncoder(Type::DOUBLE, BUFFER_SIZE), new PlainDecoder<Type::DOUBLE>()));
 
   all_encodings[Type::BYTE_ARRAY].push_back(EncodeDecode(
       new PlainEncoder(Type::BYTE_ARRAY, BUFFER_SIZE),
-      new PlainDecoder(Type::BYTE_ARRAY)));
+      new PlainDecoder<Type::BYTE_ARRAY>()));
   all_encodings[Type::BYTE_ARRAY].push_back(EncodeDecode(
       new DeltaLengthByteArrayEncoder(BUFFER_SIZE),
       new DeltaLengthByteArrayDecoder()));
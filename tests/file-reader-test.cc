@@ -0,0 +1,1323 @@
+// Copyright 2012 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include <parquet/compact-protocol.h>
+#include <parquet/file-reader.h>
+#include <parquet/page-header.h>
+#include <parquet/thread-pool.h>
+#include "compression/codec.h"
+
+using namespace parquet;
+using namespace parquet_cpp;
+using namespace std;
+
+// Returns the path of a file in the data directory next to this test's source.
+static string DataFile(const string& name) {
+  string path(__FILE__);
+  return path.substr(0, path.rfind('/')) + "/../data/" + name;
+}
+
+// Writes 'len' bytes of 'data' to a new temporary file and returns its path.
+static string WriteTempFile(const char* data, int len) {
+  char path[] = "/tmp/parquet-file-reader-test.XXXXXX";
+  int fd = mkstemp(path);
+  EXPECT_GE(fd, 0);
+  EXPECT_EQ(write(fd, data, len), len);
+  close(fd);
+  return path;
+}
+
+TEST(LocalFileSource, ReadAt) {
+  string path = WriteTempFile("0123456789", 10);
+  LocalFileSource source(path);
+  EXPECT_EQ(source.Size(), 10);
+
+  uint8_t buffer[10];
+  EXPECT_EQ(source.ReadAt(3, 4, buffer), 4);
+  EXPECT_EQ(memcmp(buffer, "3456", 4), 0);
+  // Reads past the end are short.
+  EXPECT_EQ(source.ReadAt(8, 5, buffer), 2);
+  EXPECT_EQ(memcmp(buffer, "89", 2), 0);
+  unlink(path.c_str());
+
+  EXPECT_THROW(LocalFileSource("/nonexistent/file"), ParquetException);
+}
+
+TEST(MemoryMappedSource, ReadAt) {
+  string path = WriteTempFile("0123456789", 10);
+  MemoryMappedSource source(path);
+  EXPECT_EQ(source.Size(), 10);
+
+  uint8_t buffer[10];
+  EXPECT_EQ(source.ReadAt(3, 4, buffer), 4);
+  EXPECT_EQ(memcmp(buffer, "3456", 4), 0);
+  EXPECT_EQ(source.ReadAt(8, 5, buffer), 2);
+  EXPECT_EQ(memcmp(buffer, "89", 2), 0);
+
+  // Ranges in the file are returned in place.
+  const uint8_t* range = source.GetRange(2, 8);
+  ASSERT_TRUE(range != NULL);
+  EXPECT_EQ(memcmp(range, "23456789", 8), 0);
+  EXPECT_TRUE(source.GetRange(8, 5) == NULL);
+  source.WillNeed(0, 10);
+  unlink(path.c_str());
+
+  // Other sources do not have the bytes in memory.
+  path = WriteTempFile("0123456789", 10);
+  EXPECT_TRUE(LocalFileSource(path).GetRange(0, 10) == NULL);
+  unlink(path.c_str());
+
+  string empty = WriteTempFile("", 0);
+  EXPECT_EQ(MemoryMappedSource(empty).Size(), 0);
+  unlink(empty.c_str());
+
+  EXPECT_THROW(MemoryMappedSource("/nonexistent/file"), ParquetException);
+}
+
+TEST(BufferedInputStream, Read) {
+  string data;
+  for (int i = 0; i < 100; ++i) data += static_cast<char>('a' + i % 26);
+  string path = WriteTempFile(data.data(), data.size());
+  LocalFileSource source(path);
+
+  BufferedInputStream stream(&source, 10, 80, 8);
+  int num_bytes;
+  // Peeks larger than the buffer grow it.
+  const uint8_t* buffer = stream.Peek(20, &num_bytes);
+  EXPECT_EQ(num_bytes, 20);
+  EXPECT_EQ(memcmp(buffer, data.data() + 10, 20), 0);
+  int64_t offset = 10;
+  while (offset < 90) {
+    buffer = stream.Read(7, &num_bytes);
+    EXPECT_EQ(num_bytes, ::min<int64_t>(7, 90 - offset));
+    EXPECT_EQ(memcmp(buffer, data.data() + offset, num_bytes), 0);
+    offset += num_bytes;
+  }
+  stream.Read(1, &num_bytes);
+  EXPECT_EQ(num_bytes, 0);
+
+  BufferedInputStream truncated(&source, 90, 20, 8);
+  truncated.Read(8, &num_bytes);
+  EXPECT_EQ(num_bytes, 8);
+  EXPECT_THROW(truncated.Read(8, &num_bytes), ParquetException);
+  unlink(path.c_str());
+}
+
+TEST(PrefetchingInputStream, Read) {
+  string data;
+  for (int i = 0; i < 100; ++i) data += static_cast<char>('a' + i % 26);
+  string path = WriteTempFile(data.data(), data.size());
+  LocalFileSource source(path);
+
+  // Small blocks and budget so reads span blocks and the read task stops for room.
+  PrefetchingInputStream stream(&source, 10, 80, 7, 16);
+  int num_bytes;
+  const uint8_t* buffer = stream.Peek(20, &num_bytes);
+  EXPECT_EQ(num_bytes, 20);
+  EXPECT_EQ(memcmp(buffer, data.data() + 10, 20), 0);
+  int64_t offset = 10;
+  while (offset < 90) {
+    buffer = stream.Read(9, &num_bytes);
+    EXPECT_EQ(num_bytes, ::min<int64_t>(9, 90 - offset));
+    EXPECT_EQ(memcmp(buffer, data.data() + offset, num_bytes), 0);
+    offset += num_bytes;
+  }
+  stream.Read(1, &num_bytes);
+  EXPECT_EQ(num_bytes, 0);
+
+  // Stopping early does not wait for the rest of the range.
+  { PrefetchingInputStream unread(&source, 0, 100, 1, 1); }
+
+  // A range past the end of the file fails when the missing bytes are needed.
+  PrefetchingInputStream truncated(&source, 90, 20, 8, 64);
+  truncated.Read(8, &num_bytes);
+  EXPECT_EQ(num_bytes, 8);
+  EXPECT_THROW(truncated.Read(8, &num_bytes), ParquetException);
+  unlink(path.c_str());
+}
+
+// More streams than pool threads, read in turns: the read tasks give their thread
+// back whenever a stream's budget is full.
+TEST(PrefetchingInputStream, SharedPool) {
+  string data;
+  for (int i = 0; i < 1000; ++i) data += static_cast<char>(i % 251);
+  string path = WriteTempFile(data.data(), data.size());
+  LocalFileSource source(path);
+
+  ThreadPool pool(2);
+  const int NUM_STREAMS = 16;
+  vector<boost::shared_ptr<PrefetchingInputStream> > streams;
+  for (int i = 0; i < NUM_STREAMS; ++i) {
+    streams.push_back(boost::shared_ptr<PrefetchingInputStream>(
+        new PrefetchingInputStream(&source, i, 1000 - i, 16, 32, &pool)));
+  }
+  for (int offset = 0; offset < 1000; offset += 10) {
+    for (int i = 0; i < NUM_STREAMS; ++i) {
+      if (offset + i >= 1000) continue;
+      int num_bytes;
+      const uint8_t* buffer = streams[i]->Read(10, &num_bytes);
+      EXPECT_EQ(num_bytes, ::min(10, 1000 - offset - i));
+      EXPECT_EQ(memcmp(buffer, data.data() + offset + i, num_bytes), 0);
+    }
+  }
+  // Each stream needed several tasks.
+  EXPECT_GT(pool.num_tasks_submitted(), NUM_STREAMS);
+  // Streams destroyed before they are read do not wait for the whole range.
+  for (int i = 0; i < NUM_STREAMS; ++i) {
+    PrefetchingInputStream unread(&source, 0, 1000, 1, 1, &pool);
+  }
+  streams.clear();
+  unlink(path.c_str());
+}
+
+// Reads ranges that span several ring batches, one past the end of the file.
+TEST(IoUringSource, ReadRanges) {
+  string data;
+  for (int i = 0; i < 1000; ++i) data += static_cast<char>(i % 251);
+  string path = WriteTempFile(data.data(), data.size());
+  IoUringSource source(path, 4);
+
+  vector<ReadRange> ranges;
+  for (int i = 0; i < 10; ++i) ranges.push_back(ReadRange(i * 97, 10 + i * 3));
+  vector<vector<uint8_t> > buffers(ranges.size());
+  vector<uint8_t*> read_buffers;
+  for (int i = 0; i < ranges.size(); ++i) {
+    buffers[i].resize(ranges[i].length);
+    read_buffers.push_back(&buffers[i][0]);
+  }
+  source.ReadRanges(ranges, read_buffers);
+  for (int i = 0; i < ranges.size(); ++i) {
+    EXPECT_EQ(memcmp(&buffers[i][0], data.data() + ranges[i].offset,
+        ranges[i].length), 0);
+  }
+
+  ranges.push_back(ReadRange(995, 10));
+  uint8_t tail[10];
+  read_buffers.push_back(tail);
+  EXPECT_THROW(source.ReadRanges(ranges, read_buffers), ParquetException);
+  unlink(path.c_str());
+}
+
+TEST(CoalesceReadRanges, Merge) {
+  vector<ReadRange> ranges;
+  ranges.push_back(ReadRange(100, 10));
+  ranges.push_back(ReadRange(0, 10));
+  ranges.push_back(ReadRange(15, 5));
+  ranges.push_back(ReadRange(18, 4));
+  ranges.push_back(ReadRange(40, 10));
+
+  // Only overlapping and adjacent ranges are merged without holes.
+  vector<ReadRange> reads = CoalesceReadRanges(ranges, 0);
+  ASSERT_EQ(reads.size(), 4);
+  EXPECT_EQ(reads[0].offset, 0);
+  EXPECT_EQ(reads[0].length, 10);
+  EXPECT_EQ(reads[1].offset, 15);
+  EXPECT_EQ(reads[1].length, 7);
+  EXPECT_EQ(reads[2].offset, 40);
+  EXPECT_EQ(reads[3].offset, 100);
+
+  reads = CoalesceReadRanges(ranges, 20);
+  ASSERT_EQ(reads.size(), 2);
+  EXPECT_EQ(reads[0].offset, 0);
+  EXPECT_EQ(reads[0].length, 50);
+  EXPECT_EQ(reads[1].offset, 100);
+  EXPECT_EQ(reads[1].length, 10);
+
+  reads = CoalesceReadRanges(ranges, 1000);
+  ASSERT_EQ(reads.size(), 1);
+  EXPECT_EQ(reads[0].length, 110);
+
+  EXPECT_TRUE(CoalesceReadRanges(vector<ReadRange>(), 0).empty());
+}
+
+TEST(ParquetFileReader, InvalidFile) {
+  string too_short = WriteTempFile("PAR1", 4);
+  EXPECT_THROW(ParquetFileReader::Open(too_short), ParquetException);
+  unlink(too_short.c_str());
+
+  string bad_magic = WriteTempFile("0123456789abcdef", 16);
+  EXPECT_THROW(ParquetFileReader::Open(bad_magic), ParquetException);
+  unlink(bad_magic.c_str());
+
+  // A footer claiming more metadata than the file holds.
+  string bad_len = WriteTempFile("PAR1\xff\x00\x00\x00PAR1", 12);
+  EXPECT_THROW(ParquetFileReader::Open(bad_len), ParquetException);
+  unlink(bad_len.c_str());
+}
+
+// Source that counts the reads of the file it wraps.
+class CountingSource : public LocalFileSource {
+ public:
+  explicit CountingSource(const string& path) : LocalFileSource(path), num_reads_(0) {}
+
+  virtual int64_t ReadAt(int64_t offset, int64_t num_bytes, uint8_t* buffer) {
+    ++num_reads_;
+    return LocalFileSource::ReadAt(offset, num_bytes, buffer);
+  }
+
+  int num_reads() const { return num_reads_; }
+
+ private:
+  int num_reads_;
+};
+
+TEST(ParquetFileReader, FooterReads) {
+  string path = DataFile("alltypes_plain.parquet");
+  boost::shared_ptr<CountingSource> source(new CountingSource(path));
+  ParquetFileReader file(source);
+  EXPECT_EQ(source->num_reads(), 1);
+
+  // A footer that does not fit in the speculative read takes a second one.
+  boost::shared_ptr<CountingSource> small_read_source(new CountingSource(path));
+  ParquetFileReader small_read_file(small_read_source, 16);
+  EXPECT_EQ(small_read_source->num_reads(), 2);
+  EXPECT_EQ(small_read_file.metadata(), file.metadata());
+
+  boost::shared_ptr<RandomAccessSource> mapped_source(new MemoryMappedSource(path));
+  EXPECT_EQ(ParquetFileReader(mapped_source).metadata(), file.metadata());
+}
+
+TEST(ParquetFileReader, LazyFooter) {
+  string path = DataFile("alltypes_plain.parquet");
+  boost::shared_ptr<RandomAccessSource> source(new LocalFileSource(path));
+  ParquetFileReader file(source);
+  ParquetFileReader lazy_file(source, ParquetFileReader::DEFAULT_FOOTER_READ_SIZE,
+      true);
+  ASSERT_TRUE(lazy_file.lazy_metadata() != NULL);
+  EXPECT_TRUE(file.lazy_metadata() == NULL);
+
+  // Everything but the row groups is deserialized up front.
+  const FileMetaData& metadata = file.metadata();
+  FileMetaData lazy_metadata = lazy_file.metadata();
+  EXPECT_TRUE(lazy_metadata.row_groups.empty());
+  lazy_metadata.row_groups = metadata.row_groups;
+  EXPECT_EQ(lazy_metadata, metadata);
+
+  EXPECT_EQ(lazy_file.num_row_groups(), 1);
+  RowGroup row_group;
+  lazy_file.lazy_metadata()->GetRowGroup(0, &row_group);
+  EXPECT_EQ(row_group, metadata.row_groups[0]);
+  EXPECT_THROW(lazy_file.lazy_metadata()->GetRowGroup(1, &row_group),
+      ParquetException);
+
+  boost::shared_ptr<RowGroupReader> lazy_row_group = lazy_file.RowGroup(0);
+  EXPECT_EQ(lazy_row_group->num_rows(), 8);
+  EXPECT_EQ(lazy_row_group->num_columns(), metadata.row_groups[0].columns.size());
+  for (int i = 0; i < lazy_row_group->num_columns(); ++i) {
+    EXPECT_EQ(lazy_row_group->column_metadata(i),
+        metadata.row_groups[0].columns[i].meta_data);
+  }
+  EXPECT_THROW(lazy_row_group->column_metadata(lazy_row_group->num_columns()),
+      ParquetException);
+
+  boost::shared_ptr<ColumnReader> reader = lazy_row_group->Column(0);
+  int16_t def_levels[16];
+  int32_t values[16];
+  int64_t values_read = 0;
+  EXPECT_EQ(static_cast<Int32Reader*>(reader.get())->ReadBatch(16, def_levels, NULL,
+      values, &values_read), 8);
+  EXPECT_EQ(values_read, 8);
+
+  // A truncated footer is an error.
+  vector<uint8_t> truncated(16, 0x15);
+  EXPECT_THROW(LazyFileMetaData(&truncated[0], truncated.size()), ParquetException);
+}
+
+// Corrupt footers fail cleanly instead of allocating or recursing without bound.
+TEST(LazyFileMetaData, CorruptFooter) {
+  // Lists of 2^31 - 1 row groups or schema elements in a few bytes.
+  uint8_t huge_row_groups[] = { 0x49, 0xfc, 0xff, 0xff, 0xff, 0xff, 0x07, 0x00 };
+  EXPECT_THROW(LazyFileMetaData(huge_row_groups, sizeof(huge_row_groups)),
+      ParquetException);
+  uint8_t huge_schema[] = { 0x29, 0xfc, 0xff, 0xff, 0xff, 0xff, 0x07, 0x00 };
+  EXPECT_THROW(LazyFileMetaData(huge_schema, sizeof(huge_schema)), ParquetException);
+
+  // An unknown field 7 holding structs nested 'depth' deep.
+  for (int depth = 10; depth <= 100000; depth *= 100) {
+    vector<uint8_t> nested(1, 0x7c);
+    nested.insert(nested.end(), depth, 0x1c);
+    // The STOPs of the nested structs, field 7 and the footer.
+    nested.insert(nested.end(), depth + 2, 0x00);
+    if (depth <= CompactProtocolReader::MAX_SKIP_DEPTH) {
+      EXPECT_NO_THROW(LazyFileMetaData(&nested[0], nested.size()));
+    } else {
+      EXPECT_THROW(LazyFileMetaData(&nested[0], nested.size()), ParquetException);
+    }
+  }
+}
+
+TEST(MetadataCache, LookupAndEvict) {
+  boost::shared_ptr<ParquetFileReader> file = ParquetFileReader::Open(
+      DataFile("alltypes_plain.parquet"), ParquetFileReader::PREAD, NULL);
+  boost::shared_ptr<const FileMetaData> metadata;
+  boost::shared_ptr<const Schema> schema;
+
+  MetadataCache cache;
+  EXPECT_FALSE(cache.Lookup("a", 10, 1, &metadata, &schema));
+  cache.Insert("a", 10, 1, file->shared_metadata(), file->shared_schema());
+  EXPECT_TRUE(cache.Lookup("a", 10, 1, &metadata, &schema));
+  EXPECT_EQ(metadata.get(), &file->metadata());
+  EXPECT_EQ(schema.get(), file->schema());
+  // A file with a different size or modification time is a different file.
+  EXPECT_FALSE(cache.Lookup("a", 11, 1, &metadata, &schema));
+  EXPECT_FALSE(cache.Lookup("a", 10, 2, &metadata, &schema));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 3);
+  EXPECT_EQ(cache.num_entries(), 1);
+  int64_t entry_size = cache.size();
+  EXPECT_GT(entry_size, 0);
+
+  // Shrinking the cache evicts the least recently used entries.
+  cache.Insert("b", 10, 1, file->shared_metadata(), file->shared_schema());
+  cache.Insert("c", 10, 1, file->shared_metadata(), file->shared_schema());
+  EXPECT_TRUE(cache.Lookup("a", 10, 1, &metadata, &schema));
+  cache.set_capacity(2 * entry_size);
+  EXPECT_EQ(cache.num_entries(), 2);
+  EXPECT_TRUE(cache.Lookup("a", 10, 1, &metadata, &schema));
+  EXPECT_FALSE(cache.Lookup("b", 10, 1, &metadata, &schema));
+  EXPECT_TRUE(cache.Lookup("c", 10, 1, &metadata, &schema));
+
+  // Entries larger than the capacity are not added.
+  MetadataCache small_cache(entry_size - 1);
+  small_cache.Insert("a", 10, 1, file->shared_metadata(), file->shared_schema());
+  EXPECT_EQ(small_cache.num_entries(), 0);
+}
+
+TEST(MetadataCache, Open) {
+  string path = DataFile("alltypes_plain.parquet");
+  MetadataCache cache;
+  boost::shared_ptr<ParquetFileReader> file =
+      ParquetFileReader::Open(path, ParquetFileReader::PREAD, &cache);
+  EXPECT_EQ(cache.misses(), 1);
+  boost::shared_ptr<ParquetFileReader> reopened =
+      ParquetFileReader::Open(path, ParquetFileReader::MMAP, &cache);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(&reopened->metadata(), &file->metadata());
+  EXPECT_EQ(reopened->schema(), file->schema());
+
+  // Projections are set on a copy of the schema, not on the shared one.
+  EXPECT_NE(reopened->mutable_schema(), reopened->schema());
+  EXPECT_EQ(reopened->mutable_schema()->leaves().size(),
+      file->schema()->leaves().size());
+}
+
+// Reads the id column of alltypes_plain.parquet, which holds 0 to 7.
+static void TestReadColumn(ParquetFileReader::IoMode io_mode, int64_t read_ahead_bytes,
+    int stream_buffer_size, bool load_columns) {
+  boost::shared_ptr<ParquetFileReader> file =
+      ParquetFileReader::Open(DataFile("alltypes_plain.parquet"), io_mode);
+  file->set_read_ahead_bytes(read_ahead_bytes);
+  file->set_stream_buffer_size(stream_buffer_size);
+  file->WillReadRowGroups(vector<int>(1, 0));
+  EXPECT_THROW(file->WillReadRowGroups(vector<int>(1, 1)), ParquetException);
+  EXPECT_EQ(file->num_row_groups(), 1);
+  EXPECT_EQ(file->metadata().num_rows, 8);
+  EXPECT_THROW(file->RowGroup(1), ParquetException);
+
+  boost::shared_ptr<RowGroupReader> row_group = file->RowGroup(0);
+  if (load_columns) {
+    vector<int> columns;
+    for (int i = 0; i < row_group->num_columns(); ++i) columns.push_back(i);
+    RowGroupReader::LoadColumns(vector<RowGroupReader*>(1, row_group.get()), columns,
+        0);
+  }
+  EXPECT_EQ(row_group->num_rows(), 8);
+  EXPECT_EQ(row_group->num_columns(), file->schema()->leaves().size());
+  EXPECT_EQ(row_group->column_metadata(0).type, Type::INT32);
+
+  boost::shared_ptr<ColumnReader> reader = row_group->Column(0);
+  EXPECT_EQ(reader->name(), "id");
+  int16_t def_levels[16];
+  int32_t values[16];
+  int64_t values_read = 0;
+  EXPECT_EQ(static_cast<Int32Reader*>(reader.get())->ReadBatch(16, def_levels, NULL,
+      values, &values_read), 8);
+  EXPECT_EQ(values_read, 8);
+  int sum = 0;
+  for (int i = 0; i < values_read; ++i) sum += values[i];
+  EXPECT_EQ(sum, 28);
+  EXPECT_FALSE(reader->HasNext());
+}
+
+TEST(ParquetFileReader, ReadColumn) {
+  TestReadColumn(ParquetFileReader::PREAD, 0, 0, false);
+}
+
+TEST(ParquetFileReader, ReadColumnMemoryMapped) {
+  TestReadColumn(ParquetFileReader::MMAP, 0, 0, false);
+}
+
+TEST(ParquetFileReader, ReadColumnReadAhead) {
+  TestReadColumn(ParquetFileReader::PREAD, 16, 0, false);
+}
+
+TEST(ParquetFileReader, ReadColumnBuffered) {
+  TestReadColumn(ParquetFileReader::PREAD, 0, 16, false);
+}
+
+TEST(ParquetFileReader, ReadColumnLoaded) {
+  TestReadColumn(ParquetFileReader::PREAD, 0, 0, true);
+  TestReadColumn(ParquetFileReader::MMAP, 0, 0, true);
+  TestReadColumn(ParquetFileReader::IO_URING, 0, 0, true);
+}
+
+// Serializes 'header' with thrift's compact protocol.
+static vector<uint8_t> SerializePageHeader(const PageHeader& header) {
+  boost::shared_ptr<apache::thrift::transport::TMemoryBuffer> mem(
+      new apache::thrift::transport::TMemoryBuffer());
+  apache::thrift::protocol::TCompactProtocolT<
+      apache::thrift::transport::TMemoryBuffer> protocol(mem);
+  header.write(&protocol);
+  uint8_t* bytes;
+  uint32_t len;
+  mem->getBuffer(&bytes, &len);
+  return vector<uint8_t>(bytes, bytes + len);
+}
+
+// Checks that DeserializePageHeader() parses 'header' like thrift does.
+static void TestDeserializePageHeader(const PageHeader& header) {
+  vector<uint8_t> bytes = SerializePageHeader(header);
+  uint32_t header_len = bytes.size();
+  // Trailing bytes (the page) are not part of the header.
+  bytes.resize(bytes.size() + 10, 0xff);
+  uint32_t thrift_len = bytes.size();
+  PageHeader thrift_header;
+  DeserializeThriftMsg(&bytes[0], &thrift_len, &thrift_header);
+  EXPECT_EQ(thrift_len, header_len);
+
+  uint32_t len = bytes.size();
+  PageHeader parsed_header;
+  DeserializePageHeader(&bytes[0], &len, &parsed_header);
+  EXPECT_EQ(len, header_len);
+  EXPECT_EQ(parsed_header, thrift_header);
+
+  // Truncated headers are errors.
+  for (int i = 0; i < header_len; ++i) {
+    uint32_t truncated_len = i;
+    EXPECT_THROW(DeserializePageHeader(&bytes[0], &truncated_len, &parsed_header),
+        ParquetException);
+  }
+}
+
+TEST(PageHeader, Deserialize) {
+  PageHeader header;
+  header.type = PageType::DATA_PAGE;
+  header.uncompressed_page_size = 1024 * 1024;
+  header.compressed_page_size = 1000;
+  header.__set_crc(-12345);
+  header.data_page_header.num_values = 100;
+  header.data_page_header.encoding = Encoding::PLAIN_DICTIONARY;
+  header.data_page_header.definition_level_encoding = Encoding::RLE;
+  header.data_page_header.repetition_level_encoding = Encoding::BIT_PACKED;
+  header.__isset.data_page_header = true;
+  TestDeserializePageHeader(header);
+
+  header.data_page_header.statistics.__set_max("max");
+  header.data_page_header.statistics.__set_min(string(200, 'x'));
+  header.data_page_header.statistics.__set_null_count(7);
+  header.data_page_header.__isset.statistics = true;
+  TestDeserializePageHeader(header);
+
+  PageHeader dictionary_header;
+  dictionary_header.type = PageType::DICTIONARY_PAGE;
+  dictionary_header.uncompressed_page_size = 10;
+  dictionary_header.compressed_page_size = 10;
+  dictionary_header.dictionary_page_header.num_values = 2;
+  dictionary_header.dictionary_page_header.encoding = Encoding::PLAIN;
+  dictionary_header.dictionary_page_header.__set_is_sorted(true);
+  dictionary_header.__isset.dictionary_page_header = true;
+  TestDeserializePageHeader(dictionary_header);
+}
+
+TEST(PageHeader, SkipsUnknownFields) {
+  // The parser does not read DataPageHeaderV2s.
+  PageHeader header;
+  header.type = PageType::DATA_PAGE_V2;
+  header.uncompressed_page_size = 10;
+  header.compressed_page_size = 10;
+  header.data_page_header_v2.num_values = 2;
+  header.data_page_header_v2.statistics.__set_max("max");
+  header.data_page_header_v2.__isset.statistics = true;
+  header.__isset.data_page_header_v2 = true;
+  vector<uint8_t> bytes = SerializePageHeader(header);
+  uint32_t len = bytes.size();
+  PageHeader parsed_header;
+  DeserializePageHeader(&bytes[0], &len, &parsed_header);
+  EXPECT_EQ(len, bytes.size());
+  EXPECT_EQ(parsed_header.type, PageType::DATA_PAGE_V2);
+  EXPECT_EQ(parsed_header.compressed_page_size, 10);
+  EXPECT_FALSE(parsed_header.__isset.data_page_header_v2);
+
+  // A header without its required fields is an error: here only the empty struct.
+  uint8_t empty_struct[] = { 0 };
+  len = sizeof(empty_struct);
+  EXPECT_THROW(DeserializePageHeader(empty_struct, &len, &parsed_header),
+      ParquetException);
+}
+
+TEST(ThriftDeserializer, Reuse) {
+  PageHeader header;
+  header.type = PageType::DICTIONARY_PAGE;
+  header.uncompressed_page_size = 10;
+  header.compressed_page_size = 10;
+  header.dictionary_page_header.num_values = 2;
+  header.dictionary_page_header.encoding = Encoding::PLAIN;
+  header.dictionary_page_header.__set_is_sorted(true);
+  header.__isset.dictionary_page_header = true;
+  vector<uint8_t> bytes = SerializePageHeader(header);
+
+  ThriftDeserializer deserializer;
+  for (int i = 0; i < 3; ++i) {
+    uint32_t len = bytes.size();
+    PageHeader result;
+    deserializer.Deserialize(&bytes[0], &len, &result);
+    EXPECT_EQ(len, bytes.size());
+    EXPECT_EQ(result, header);
+
+    // A failed read does not break the next one.
+    len = bytes.size() - 1;
+    EXPECT_THROW(deserializer.Deserialize(&bytes[0], &len, &result),
+        ParquetException);
+  }
+}
+
+// Appends 'levels' to a data page: their length and then their RLE encoding.
+static void AppendLevels(const vector<int16_t>& levels, int max_level,
+    vector<uint8_t>* data) {
+  int bit_width = impala::BitUtil::NumRequiredBits(max_level);
+  vector<uint8_t> buffer(impala::RleEncoder::MaxBufferSize(bit_width, levels.size()));
+  impala::RleEncoder encoder(&buffer[0], buffer.size(), bit_width);
+  for (int i = 0; i < levels.size(); ++i) EXPECT_TRUE(encoder.Put(levels[i]));
+  uint32_t len = encoder.Flush();
+  data->insert(data->end(), reinterpret_cast<uint8_t*>(&len),
+      reinterpret_cast<uint8_t*>(&len) + sizeof(len));
+  data->insert(data->end(), buffer.begin(), buffer.begin() + len);
+}
+
+// Returns the PLAIN encoding of 'values'.
+static vector<uint8_t> PlainBytes(const vector<int32_t>& values) {
+  if (values.empty()) return vector<uint8_t>();
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&values[0]);
+  return vector<uint8_t>(bytes, bytes + values.size() * sizeof(int32_t));
+}
+
+// A single INT32 column "x" and a column chunk for it, built page by page.
+struct Int32Column {
+  Int32Column(FieldRepetitionType::type repetition, CompressionCodec::type codec_type)
+    : codec(Codec::Create(codec_type)) {
+    vector<SchemaElement> schema_elements(2);
+    schema_elements[0].name = "schema";
+    schema_elements[0].__set_num_children(1);
+    schema_elements[1].name = "x";
+    schema_elements[1].__set_type(Type::INT32);
+    schema_elements[1].__set_repetition_type(repetition);
+    schema = Schema::FromParquet(schema_elements);
+    metadata.type = Type::INT32;
+    metadata.codec = codec_type;
+  }
+
+  const Schema::Element* element() const { return schema->leaves()[0]; }
+
+  // Appends a page with 'header' and the uncompressed contents 'data', compressed
+  // with the column's codec. The page sizes in 'header' are set here.
+  void AddPage(PageHeader header, const vector<uint8_t>& data) {
+    vector<uint8_t> compressed(data);
+    if (codec.get() != NULL) {
+      const uint8_t* input = data.empty() ? NULL : &data[0];
+      compressed.resize(codec->MaxCompressedLen(data.size(), input));
+      compressed.resize(codec->Compress(data.size(), input, compressed.size(),
+          &compressed[0]));
+    }
+    header.uncompressed_page_size = data.size();
+    header.compressed_page_size = compressed.size();
+    vector<uint8_t> header_bytes = SerializePageHeader(header);
+    chunk.insert(chunk.end(), header_bytes.begin(), header_bytes.end());
+    chunk.insert(chunk.end(), compressed.begin(), compressed.end());
+  }
+
+  // Appends a data page of 'num_levels' entries: their repetition and definition
+  // levels, for columns that have them, followed by 'values', the encoded non-NULL
+  // values.
+  void AddDataPage(Encoding::type encoding, int num_levels,
+      const vector<int16_t>& def_levels, const vector<int16_t>& rep_levels,
+      const vector<uint8_t>& values) {
+    vector<uint8_t> data;
+    if (element()->max_rep_level() > 0) {
+      AppendLevels(rep_levels, element()->max_rep_level(), &data);
+    }
+    if (element()->max_def_level() > 0) {
+      AppendLevels(def_levels, element()->max_def_level(), &data);
+    }
+    data.insert(data.end(), values.begin(), values.end());
+
+    PageHeader header;
+    header.type = PageType::DATA_PAGE;
+    header.data_page_header.num_values = num_levels;
+    header.data_page_header.encoding = encoding;
+    header.data_page_header.definition_level_encoding = Encoding::RLE;
+    header.data_page_header.repetition_level_encoding = Encoding::RLE;
+    header.__isset.data_page_header = true;
+    AddPage(header, data);
+  }
+
+  // Appends a PLAIN data page. 'values' are the non-NULL values; the levels are only
+  // needed if the column has them.
+  void AddPlainPage(const vector<int32_t>& values,
+      const vector<int16_t>& def_levels = vector<int16_t>(),
+      const vector<int16_t>& rep_levels = vector<int16_t>()) {
+    int num_levels = element()->max_def_level() > 0 ? def_levels.size() : values.size();
+    AddDataPage(Encoding::PLAIN, num_levels, def_levels, rep_levels,
+        PlainBytes(values));
+  }
+
+  // Appends the column's dictionary page.
+  void AddDictionaryPage(const vector<int32_t>& dictionary) {
+    PageHeader header;
+    header.type = PageType::DICTIONARY_PAGE;
+    header.dictionary_page_header.num_values = dictionary.size();
+    header.dictionary_page_header.encoding = Encoding::PLAIN;
+    header.__isset.dictionary_page_header = true;
+    AddPage(header, PlainBytes(dictionary));
+  }
+
+  // Appends an RLE_DICTIONARY data page of the non-NULL values 'indices'.
+  void AddIndexPage(const vector<int32_t>& indices,
+      const vector<int16_t>& def_levels = vector<int16_t>()) {
+    const int BIT_WIDTH = 8;
+    vector<uint8_t> data(1 + impala::RleEncoder::MaxBufferSize(BIT_WIDTH,
+        indices.size()));
+    data[0] = BIT_WIDTH;
+    impala::RleEncoder encoder(&data[1], data.size() - 1, BIT_WIDTH);
+    for (int i = 0; i < indices.size(); ++i) EXPECT_TRUE(encoder.Put(indices[i]));
+    data.resize(1 + encoder.Flush());
+    int num_levels = element()->max_def_level() > 0 ? def_levels.size() : indices.size();
+    AddDataPage(Encoding::RLE_DICTIONARY, num_levels, def_levels, vector<int16_t>(),
+        data);
+  }
+
+  // Appends 'num_pages' PLAIN pages of 'values_per_page' values each. The values
+  // are consecutive, starting at 0.
+  void AddSequentialPages(int num_pages, int values_per_page) {
+    int32_t next_value = 0;
+    for (int i = 0; i < num_pages; ++i) {
+      vector<int32_t> values(values_per_page);
+      for (int j = 0; j < values_per_page; ++j) values[j] = next_value++;
+      AddPlainPage(values);
+    }
+  }
+
+  boost::shared_ptr<Schema> schema;
+  ColumnMetaData metadata;
+  vector<uint8_t> chunk;
+  // NULL if the column is UNCOMPRESSED.
+  boost::shared_ptr<Codec> codec;
+};
+
+// Page headers can be larger than the bytes first peeked for them, e.g. with large
+// statistics.
+TEST(ColumnReader, LargePageHeader) {
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::UNCOMPRESSED);
+  int32_t values[] = { 1, 2, 3 };
+  PageHeader header;
+  header.type = PageType::DATA_PAGE;
+  header.data_page_header.num_values = 3;
+  header.data_page_header.encoding = Encoding::PLAIN;
+  header.data_page_header.definition_level_encoding = Encoding::RLE;
+  header.data_page_header.repetition_level_encoding = Encoding::RLE;
+  header.data_page_header.statistics.__set_max(string(100 * 1024, 'x'));
+  header.data_page_header.__isset.statistics = true;
+  header.__isset.data_page_header = true;
+  column.AddPage(header, PlainBytes(vector<int32_t>(values, values + 3)));
+  int header_len = column.chunk.size() - sizeof(values);
+  ASSERT_GT(header_len, 100 * 1024);
+
+  // With the hand written and the thrift page header parser.
+  for (int thrift = 0; thrift < 2; ++thrift) {
+    ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+    config.thrift_page_headers = thrift;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    int32_t result[4];
+    int64_t values_read = 0;
+    EXPECT_EQ(reader.ReadBatch(4, NULL, NULL, result, &values_read), 3);
+    EXPECT_EQ(values_read, 3);
+    EXPECT_EQ(memcmp(result, values, sizeof(values)), 0);
+  }
+
+  // A truncated header is an error.
+  InMemoryInputStream truncated(&column.chunk[0], header_len / 2);
+  Int32Reader truncated_reader(&column.metadata, column.element(), &truncated);
+  EXPECT_THROW(truncated_reader.HasNext(), ParquetException);
+}
+
+// ReadBatch() on nullable and repeated columns: the levels of every entry, the
+// dense non-NULL values, and batches that stop at the end of a page.
+TEST(ColumnReader, ReadBatch) {
+  Int32Column optional_column(FieldRepetitionType::OPTIONAL,
+      CompressionCodec::UNCOMPRESSED);
+  int16_t page1_def[] = { 1, 0, 1, 1, 0 };
+  int32_t page1_values[] = { 10, 11, 12 };
+  int16_t page2_def[] = { 0, 1 };
+  int32_t page2_values[] = { 13 };
+  optional_column.AddPlainPage(vector<int32_t>(page1_values, page1_values + 3),
+      vector<int16_t>(page1_def, page1_def + 5));
+  optional_column.AddPlainPage(vector<int32_t>(page2_values, page2_values + 1),
+      vector<int16_t>(page2_def, page2_def + 2));
+  {
+    InMemoryInputStream stream(&optional_column.chunk[0], optional_column.chunk.size());
+    Int32Reader reader(&optional_column.metadata, optional_column.element(), &stream);
+    EXPECT_EQ(reader.max_def_level(), 1);
+    EXPECT_EQ(reader.max_rep_level(), 0);
+    int16_t def_levels[10];
+    int32_t values[10];
+    int64_t values_read = 0;
+    EXPECT_EQ(reader.ReadBatch(3, def_levels, NULL, values, &values_read), 3);
+    EXPECT_EQ(values_read, 2);
+    EXPECT_EQ(memcmp(def_levels, page1_def, 3 * sizeof(int16_t)), 0);
+    EXPECT_EQ(values[0], 10);
+    EXPECT_EQ(values[1], 11);
+    // The batch stops at the end of the page...
+    EXPECT_EQ(reader.ReadBatch(10, def_levels, NULL, values, &values_read), 2);
+    EXPECT_EQ(values_read, 1);
+    EXPECT_EQ(def_levels[0], 1);
+    EXPECT_EQ(def_levels[1], 0);
+    EXPECT_EQ(values[0], 12);
+    // ... and the next one reads the next page.
+    EXPECT_EQ(reader.ReadBatch(10, def_levels, NULL, values, &values_read), 2);
+    EXPECT_EQ(values_read, 1);
+    EXPECT_EQ(memcmp(def_levels, page2_def, sizeof(page2_def)), 0);
+    EXPECT_EQ(values[0], 13);
+    EXPECT_FALSE(reader.HasNext());
+    EXPECT_EQ(reader.ReadBatch(10, def_levels, NULL, values, &values_read), 0);
+    EXPECT_EQ(values_read, 0);
+  }
+
+  // Rows [1, 2], [], [3] then [4, 5, 6] on the next page.
+  Int32Column repeated_column(FieldRepetitionType::REPEATED,
+      CompressionCodec::UNCOMPRESSED);
+  int16_t page1_rep[] = { 0, 1, 0, 0 };
+  int16_t page1_rep_def[] = { 1, 1, 0, 1 };
+  int32_t page1_rep_values[] = { 1, 2, 3 };
+  int16_t page2_rep[] = { 0, 1, 1 };
+  int16_t page2_rep_def[] = { 1, 1, 1 };
+  int32_t page2_rep_values[] = { 4, 5, 6 };
+  repeated_column.AddPlainPage(vector<int32_t>(page1_rep_values, page1_rep_values + 3),
+      vector<int16_t>(page1_rep_def, page1_rep_def + 4),
+      vector<int16_t>(page1_rep, page1_rep + 4));
+  repeated_column.AddPlainPage(vector<int32_t>(page2_rep_values, page2_rep_values + 3),
+      vector<int16_t>(page2_rep_def, page2_rep_def + 3),
+      vector<int16_t>(page2_rep, page2_rep + 3));
+  {
+    InMemoryInputStream stream(&repeated_column.chunk[0], repeated_column.chunk.size());
+    Int32Reader reader(&repeated_column.metadata, repeated_column.element(), &stream);
+    EXPECT_EQ(reader.max_def_level(), 1);
+    EXPECT_EQ(reader.max_rep_level(), 1);
+    int16_t def_levels[10];
+    int16_t rep_levels[10];
+    int32_t values[10];
+    int64_t values_read = 0;
+    EXPECT_EQ(reader.ReadBatch(10, def_levels, rep_levels, values, &values_read), 4);
+    EXPECT_EQ(values_read, 3);
+    EXPECT_EQ(memcmp(def_levels, page1_rep_def, sizeof(page1_rep_def)), 0);
+    EXPECT_EQ(memcmp(rep_levels, page1_rep, sizeof(page1_rep)), 0);
+    EXPECT_EQ(memcmp(values, page1_rep_values, sizeof(page1_rep_values)), 0);
+    EXPECT_EQ(reader.ReadBatch(2, def_levels, rep_levels, values, &values_read), 2);
+    EXPECT_EQ(values_read, 2);
+    EXPECT_EQ(rep_levels[0], 0);
+    EXPECT_EQ(rep_levels[1], 1);
+    EXPECT_EQ(values[0], 4);
+    EXPECT_EQ(values[1], 5);
+    EXPECT_EQ(reader.ReadBatch(2, def_levels, rep_levels, values, &values_read), 1);
+    EXPECT_EQ(values_read, 1);
+    EXPECT_EQ(rep_levels[0], 1);
+    EXPECT_EQ(values[0], 6);
+    EXPECT_FALSE(reader.HasNext());
+  }
+}
+
+// Entry i of the ReadBatchSpaced test column is NULL if this returns true, and
+// 100 + i otherwise.
+static bool IsSpacedTestNull(int i) {
+  return i % 3 == 1 || i == 9;
+}
+
+// ReadBatchSpaced() puts each value in its entry's slot and sets the entry's bit in
+// the validity bitmap, at bit offsets that are not byte aligned.
+TEST(ColumnReader, ReadBatchSpaced) {
+  // 20 entries: 12 on the first page and 8 on the second.
+  Int32Column column(FieldRepetitionType::OPTIONAL, CompressionCodec::UNCOMPRESSED);
+  vector<int16_t> def_levels[2];
+  vector<int32_t> values[2];
+  for (int i = 0; i < 20; ++i) {
+    int page = i < 12 ? 0 : 1;
+    def_levels[page].push_back(!IsSpacedTestNull(i));
+    if (!IsSpacedTestNull(i)) values[page].push_back(100 + i);
+  }
+  column.AddPlainPage(values[0], def_levels[0]);
+  column.AddPlainPage(values[1], def_levels[1]);
+
+  InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+  Int32Reader reader(&column.metadata, column.element(), &stream);
+  // Bits outside the ones written must keep this pattern.
+  const uint8_t PATTERN = 0x5a;
+  uint8_t valid_bits[8];
+  memset(valid_bits, PATTERN, sizeof(valid_bits));
+  int32_t slots[20];
+  int16_t batch_def_levels[7];
+  const int OFFSET = 3;
+  // Batches of 7 stop at the end of the first page: 7, 5, then 7 and 1.
+  int expected_batch_sizes[] = { 7, 5, 7, 1 };
+  int num_batches = 0;
+  int num_read = 0;
+  while (reader.HasNext()) {
+    ASSERT_LT(num_batches, 4);
+    int64_t null_count = -1;
+    int64_t n = reader.ReadBatchSpaced(7, batch_def_levels, slots + num_read,
+        valid_bits, OFFSET + num_read, &null_count);
+    EXPECT_EQ(n, expected_batch_sizes[num_batches++]);
+    int expected_null_count = 0;
+    for (int i = num_read; i < num_read + n; ++i) {
+      expected_null_count += IsSpacedTestNull(i);
+    }
+    EXPECT_EQ(null_count, expected_null_count);
+    num_read += n;
+  }
+  EXPECT_EQ(num_read, 20);
+  for (int i = 0; i < sizeof(valid_bits) * 8; ++i) {
+    bool bit = impala::BitUtil::GetBit(valid_bits, i);
+    if (i < OFFSET || i >= OFFSET + 20) {
+      EXPECT_EQ(bit, (PATTERN >> (i % 8)) & 1) << i;
+    } else {
+      int entry = i - OFFSET;
+      EXPECT_EQ(bit, !IsSpacedTestNull(entry)) << entry;
+      if (bit) EXPECT_EQ(slots[entry], 100 + entry);
+    }
+  }
+
+  // Without definition levels every slot has a value.
+  Int32Column required_column(FieldRepetitionType::REQUIRED,
+      CompressionCodec::UNCOMPRESSED);
+  required_column.AddSequentialPages(1, 10);
+  InMemoryInputStream required_stream(&required_column.chunk[0],
+      required_column.chunk.size());
+  Int32Reader required_reader(&required_column.metadata, required_column.element(),
+      &required_stream);
+  memset(valid_bits, 0, sizeof(valid_bits));
+  int64_t null_count = -1;
+  EXPECT_EQ(required_reader.ReadBatchSpaced(16, NULL, slots, valid_bits, 5,
+      &null_count), 10);
+  EXPECT_EQ(null_count, 0);
+  for (int i = 0; i < sizeof(valid_bits) * 8; ++i) {
+    EXPECT_EQ(impala::BitUtil::GetBit(valid_bits, i), i >= 5 && i < 15) << i;
+  }
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(slots[i], i);
+}
+
+TEST(ColumnReader, BatchSize) {
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::UNCOMPRESSED);
+  column.AddSequentialPages(2, 1000);
+  ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+  config.batch_size = 10;
+  config.max_batch_size = 64;
+
+  for (int adaptive = 0; adaptive < 2; ++adaptive) {
+    config.adaptive_batch_size = adaptive;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    EXPECT_EQ(reader.batch_size(), 10);
+    // The batch sizes after each refill.
+    vector<int> batch_sizes;
+    for (int32_t i = 0; i < 2000; ++i) {
+      bool is_null;
+      int def_level, rep_level;
+      EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), i);
+      if (batch_sizes.empty() || batch_sizes.back() != reader.batch_size()) {
+        batch_sizes.push_back(reader.batch_size());
+      }
+    }
+    EXPECT_FALSE(reader.HasNext());
+    if (adaptive) {
+      // Doubles on every refill until it reaches max_batch_size.
+      ASSERT_EQ(batch_sizes.size(), 3);
+      EXPECT_EQ(batch_sizes[0], 20);
+      EXPECT_EQ(batch_sizes[1], 40);
+      EXPECT_EQ(batch_sizes[2], 64);
+    } else {
+      ASSERT_EQ(batch_sizes.size(), 1);
+      EXPECT_EQ(batch_sizes[0], 10);
+    }
+  }
+
+  // Invalid configs are rejected.
+  InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+  for (int batch_size = -1; batch_size <= 0; ++batch_size) {
+    config.batch_size = batch_size;
+    EXPECT_THROW(Int32Reader(&column.metadata, column.element(), &stream, config),
+        ParquetException);
+  }
+  config.batch_size = 128;
+  config.adaptive_batch_size = true;
+  config.max_batch_size = 64;
+  EXPECT_THROW(Int32Reader(&column.metadata, column.element(), &stream, config),
+      ParquetException);
+  // max_batch_size only matters for adaptive batches.
+  config.adaptive_batch_size = false;
+  EXPECT_NO_THROW(Int32Reader(&column.metadata, column.element(), &stream, config));
+}
+
+// ReadBatchZeroCopy() returns values in place when the page is: in the mapping of a
+// memory mapped file for uncompressed pages, and in a buffer owned by the stream or
+// reader otherwise.
+TEST(ColumnReader, ReadBatchZeroCopy) {
+  CompressionCodec::type codecs[] = {
+      CompressionCodec::UNCOMPRESSED, CompressionCodec::SNAPPY };
+  for (int c = 0; c < 2; ++c) {
+    Int32Column column(FieldRepetitionType::REQUIRED, codecs[c]);
+    column.AddSequentialPages(3, 100);
+    string path = WriteTempFile(reinterpret_cast<const char*>(&column.chunk[0]),
+        column.chunk.size());
+    MemoryMappedSource mmap_source(path);
+    const uint8_t* mapping = mmap_source.GetRange(0, column.chunk.size());
+    ASSERT_TRUE(mapping != NULL);
+    LocalFileSource file_source(path);
+
+    for (int use_mmap = 0; use_mmap < 2; ++use_mmap) {
+      boost::scoped_ptr<InputStream> stream;
+      if (use_mmap) {
+        stream.reset(new InMemoryInputStream(mapping, column.chunk.size()));
+      } else {
+        stream.reset(new BufferedInputStream(&file_source, 0, column.chunk.size()));
+      }
+      Int32Reader reader(&column.metadata, column.element(), stream.get());
+      int32_t expected = 0;
+      while (reader.HasNext()) {
+        const int32_t* values = NULL;
+        int64_t values_read = 0;
+        EXPECT_EQ(reader.ReadBatchZeroCopy(64, NULL, NULL, &values, &values_read),
+            values_read);
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(values);
+        bool in_mapping = begin >= mapping &&
+            begin + values_read * sizeof(int32_t) <= mapping + column.chunk.size();
+        EXPECT_EQ(in_mapping,
+            use_mmap && codecs[c] == CompressionCodec::UNCOMPRESSED);
+        for (int i = 0; i < values_read; ++i) EXPECT_EQ(values[i], expected++);
+      }
+      EXPECT_EQ(expected, 300);
+    }
+    unlink(path.c_str());
+  }
+}
+
+// A writer that falls back from dictionary to PLAIN part way through the chunk:
+// indices can be read until IsDictionaryPage() turns false, then values must be.
+TEST(ColumnReader, ReadBatchIndicesFallback) {
+  Int32Column column(FieldRepetitionType::OPTIONAL, CompressionCodec::SNAPPY);
+  int32_t dictionary[] = { 100, 200, 300 };
+  column.AddDictionaryPage(vector<int32_t>(dictionary, dictionary + 3));
+  int32_t page1_indices[] = { 2, 0, 1, 2 };
+  int16_t page1_def[] = { 1, 0, 1, 1, 1 };
+  column.AddIndexPage(vector<int32_t>(page1_indices, page1_indices + 4),
+      vector<int16_t>(page1_def, page1_def + 5));
+  int32_t page2_indices[] = { 1, 1 };
+  int16_t page2_def[] = { 1, 1 };
+  column.AddIndexPage(vector<int32_t>(page2_indices, page2_indices + 2),
+      vector<int16_t>(page2_def, page2_def + 2));
+  int32_t plain_values[] = { 7, 8 };
+  int16_t plain_def[] = { 1, 0, 1 };
+  column.AddPlainPage(vector<int32_t>(plain_values, plain_values + 2),
+      vector<int16_t>(plain_def, plain_def + 3));
+
+  InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+  Int32Reader reader(&column.metadata, column.element(), &stream);
+  int16_t def_levels[10];
+  int32_t indices[10];
+  int64_t indices_read = 0;
+  ASSERT_TRUE(reader.HasNext());
+  EXPECT_TRUE(reader.IsDictionaryPage());
+  ASSERT_TRUE(reader.dictionary() != NULL);
+  EXPECT_EQ(reader.dictionary()->size(), 3);
+  EXPECT_EQ((*reader.dictionary())[1], 200);
+  EXPECT_EQ(reader.ReadBatchIndices(10, def_levels, NULL, indices, &indices_read), 5);
+  EXPECT_EQ(indices_read, 4);
+  EXPECT_EQ(memcmp(def_levels, page1_def, sizeof(page1_def)), 0);
+  EXPECT_EQ(memcmp(indices, page1_indices, sizeof(page1_indices)), 0);
+
+  // The second dictionary page.
+  ASSERT_TRUE(reader.HasNext());
+  EXPECT_TRUE(reader.IsDictionaryPage());
+  EXPECT_EQ(reader.ReadBatchIndices(10, def_levels, NULL, indices, &indices_read), 2);
+  EXPECT_EQ(indices_read, 2);
+  EXPECT_EQ(memcmp(indices, page2_indices, sizeof(page2_indices)), 0);
+
+  // The fallback to PLAIN.
+  ASSERT_TRUE(reader.HasNext());
+  EXPECT_FALSE(reader.IsDictionaryPage());
+  EXPECT_THROW(reader.ReadBatchIndices(10, def_levels, NULL, indices, &indices_read),
+      ParquetException);
+  // The dictionary is still there for the indices already read.
+  ASSERT_TRUE(reader.dictionary() != NULL);
+  int32_t values[10];
+  int64_t values_read = 0;
+  EXPECT_EQ(reader.ReadBatch(10, def_levels, NULL, values, &values_read), 3);
+  EXPECT_EQ(values_read, 2);
+  EXPECT_EQ(memcmp(def_levels, plain_def, sizeof(plain_def)), 0);
+  EXPECT_EQ(memcmp(values, plain_values, sizeof(plain_values)), 0);
+  EXPECT_FALSE(reader.HasNext());
+}
+
+TEST(ColumnReader, Skip) {
+  // 5 pages of 100 values: 0, 1, 2, ...
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::SNAPPY);
+  column.AddSequentialPages(5, 100);
+  {
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream);
+    bool is_null;
+    int def_level, rep_level;
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 0);
+    // Within the page, past values GetValue() has already decoded.
+    EXPECT_EQ(reader.Skip(10), 10);
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 11);
+    // The rest of the first page, two whole pages and part of the fourth.
+    EXPECT_EQ(reader.Skip(250), 250);
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 262);
+    // Past the end.
+    EXPECT_EQ(reader.Skip(1000), 500 - 263);
+    EXPECT_FALSE(reader.HasNext());
+    EXPECT_EQ(reader.Skip(1), 0);
+  }
+
+  // A nullable column counts rows by definition levels, not values. 3 pages of 20
+  // entries; entry i is NULL if i % 4 == 0 and i otherwise.
+  Int32Column nullable_column(FieldRepetitionType::OPTIONAL, CompressionCodec::SNAPPY);
+  for (int page = 0; page < 3; ++page) {
+    vector<int16_t> def_levels;
+    vector<int32_t> values;
+    for (int i = page * 20; i < (page + 1) * 20; ++i) {
+      def_levels.push_back(i % 4 != 0);
+      if (i % 4 != 0) values.push_back(i);
+    }
+    nullable_column.AddPlainPage(values, def_levels);
+  }
+  {
+    InMemoryInputStream stream(&nullable_column.chunk[0], nullable_column.chunk.size());
+    Int32Reader reader(&nullable_column.metadata, nullable_column.element(), &stream);
+    bool is_null;
+    int def_level, rep_level;
+    EXPECT_EQ(reader.Skip(5), 5);
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 5);
+    EXPECT_FALSE(is_null);
+    // The rest of the first page, the whole second page and 6 entries of the third.
+    EXPECT_EQ(reader.Skip(40), 40);
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 46);
+    EXPECT_EQ(reader.GetValue(&is_null, &def_level, &rep_level), 47);
+    reader.GetValue(&is_null, &def_level, &rep_level);
+    EXPECT_TRUE(is_null);
+    EXPECT_EQ(def_level, 0);
+    EXPECT_EQ(reader.Skip(100), 60 - 49);
+    EXPECT_FALSE(reader.HasNext());
+  }
+}
+
+static void AddUnderLock(boost::mutex* lock, int* sum, int value) {
+  boost::lock_guard<boost::mutex> l(*lock);
+  *sum += value;
+}
+
+TEST(ThreadPool, RunsTasks) {
+  boost::mutex lock;
+  int sum = 0;
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.num_threads(), 4);
+    for (int i = 1; i <= 100; ++i) {
+      pool.Submit(boost::bind(AddUnderLock, &lock, &sum, i));
+    }
+    // The destructor runs the queued tasks.
+  }
+  EXPECT_EQ(sum, 5050);
+  EXPECT_THROW(ThreadPool(0), ParquetException);
+}
+
+TEST(ColumnReader, DecompressionPool) {
+  const int NUM_PAGES = 20;
+  const int VALUES_PER_PAGE = 1000;
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::SNAPPY);
+  column.AddSequentialPages(NUM_PAGES, VALUES_PER_PAGE);
+
+  ThreadPool pool(2);
+  for (int pages_ahead = 1; pages_ahead <= 8; pages_ahead *= 2) {
+    ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+    config.decompression_pool = &pool;
+    config.decompression_pages_ahead = pages_ahead;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    // Skip the first page and a half.
+    EXPECT_EQ(reader.Skip(VALUES_PER_PAGE * 3 / 2), VALUES_PER_PAGE * 3 / 2);
+    int32_t expected = VALUES_PER_PAGE * 3 / 2;
+    while (reader.HasNext()) {
+      int32_t values[256];
+      int64_t values_read = 0;
+      reader.ReadBatch(256, NULL, NULL, values, &values_read);
+      for (int i = 0; i < values_read; ++i) EXPECT_EQ(values[i], expected++);
+    }
+    EXPECT_EQ(expected, NUM_PAGES * VALUES_PER_PAGE);
+  }
+
+  // Destroying a reader with pages in flight waits for them.
+  for (int i = 0; i < 10; ++i) {
+    ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+    config.decompression_pool = &pool;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    EXPECT_TRUE(reader.HasNext());
+  }
+
+  // Truncated chunks are errors.
+  Int32Column corrupt_column(FieldRepetitionType::REQUIRED, CompressionCodec::SNAPPY);
+  corrupt_column.AddSequentialPages(2, VALUES_PER_PAGE);
+  vector<uint8_t>& corrupt_chunk = corrupt_column.chunk;
+  corrupt_chunk.resize(corrupt_chunk.size() / 2);
+  ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+  config.decompression_pool = &pool;
+  InMemoryInputStream stream(&corrupt_chunk[0], corrupt_chunk.size());
+  Int32Reader reader(&corrupt_column.metadata, corrupt_column.element(), &stream,
+      config);
+  EXPECT_THROW(reader.HasNext(), ParquetException);
+}
+
+// Pages that Skip() skips entirely are not decompressed on the pool.
+TEST(ColumnReader, DecompressionPoolSkip) {
+  const int NUM_PAGES = 20;
+  const int VALUES_PER_PAGE = 1000;
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::SNAPPY);
+  column.AddSequentialPages(NUM_PAGES, VALUES_PER_PAGE);
+  ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+  config.decompression_pages_ahead = 4;
+
+  // The skip ends half way through the 19th page, so skipping from the start only
+  // decompresses the last two pages.
+  for (int read_first = 0; read_first < 2; ++read_first) {
+    ThreadPool pool(2);
+    config.decompression_pool = &pool;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    // Reading first queues the first page and the 4 after it, which are then
+    // decompressed even though they are skipped.
+    if (read_first) {
+      EXPECT_TRUE(reader.HasNext());
+      EXPECT_EQ(pool.num_tasks_submitted(), 5);
+    }
+    int64_t num_rows = VALUES_PER_PAGE * (NUM_PAGES - 1) - VALUES_PER_PAGE / 2;
+    EXPECT_EQ(reader.Skip(num_rows), num_rows);
+    int32_t expected = num_rows;
+    while (reader.HasNext()) {
+      int32_t values[256];
+      int64_t values_read = 0;
+      reader.ReadBatch(256, NULL, NULL, values, &values_read);
+      for (int i = 0; i < values_read; ++i) EXPECT_EQ(values[i], expected++);
+    }
+    EXPECT_EQ(expected, NUM_PAGES * VALUES_PER_PAGE);
+    EXPECT_EQ(pool.num_tasks_submitted(), read_first ? 7 : 2);
+  }
+}
+
+// Reads a column chunk with 'codec' compressed pages, with and without a
+// decompression pool.
+static void TestReadCompressedColumn(CompressionCodec::type codec) {
+  Int32Column column(FieldRepetitionType::REQUIRED, codec);
+  column.AddSequentialPages(3, 1000);
+  ThreadPool pool(1);
+  for (int use_pool = 0; use_pool < 2; ++use_pool) {
+    ColumnReader::Config config = ColumnReader::Config::DefaultConfig();
+    if (use_pool) config.decompression_pool = &pool;
+    InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+    Int32Reader reader(&column.metadata, column.element(), &stream, config);
+    int32_t expected = 0;
+    while (reader.HasNext()) {
+      int32_t values[256];
+      int64_t values_read = 0;
+      reader.ReadBatch(256, NULL, NULL, values, &values_read);
+      for (int i = 0; i < values_read; ++i) EXPECT_EQ(values[i], expected++);
+    }
+    EXPECT_EQ(expected, 3000);
+  }
+}
+
+TEST(ColumnReader, Lz4) {
+  TestReadCompressedColumn(CompressionCodec::LZ4);
+}
+
+// Pages written by parquet-mr with Hadoop's Lz4Codec: the raw LZ4 block is framed
+// with its big endian decompressed and compressed sizes.
+TEST(ColumnReader, Lz4HadoopFramed) {
+  Int32Column column(FieldRepetitionType::REQUIRED, CompressionCodec::LZ4);
+  vector<int32_t> values(1000);
+  for (int i = 0; i < values.size(); ++i) values[i] = i;
+  vector<uint8_t> data = PlainBytes(values);
+  vector<uint8_t> block(column.codec->MaxCompressedLen(data.size(), &data[0]));
+  block.resize(column.codec->Compress(data.size(), &data[0], block.size(),
+      &block[0]));
+  uint8_t frame_header[] = {
+      0, 0, static_cast<uint8_t>(data.size() >> 8), static_cast<uint8_t>(data.size()),
+      0, 0, static_cast<uint8_t>(block.size() >> 8), static_cast<uint8_t>(block.size()) };
+  vector<uint8_t> framed(frame_header, frame_header + sizeof(frame_header));
+  framed.insert(framed.end(), block.begin(), block.end());
+
+  PageHeader header;
+  header.type = PageType::DATA_PAGE;
+  header.uncompressed_page_size = data.size();
+  header.compressed_page_size = framed.size();
+  header.data_page_header.num_values = values.size();
+  header.data_page_header.encoding = Encoding::PLAIN;
+  header.data_page_header.definition_level_encoding = Encoding::RLE;
+  header.data_page_header.repetition_level_encoding = Encoding::RLE;
+  header.__isset.data_page_header = true;
+  column.chunk = SerializePageHeader(header);
+  column.chunk.insert(column.chunk.end(), framed.begin(), framed.end());
+
+  InMemoryInputStream stream(&column.chunk[0], column.chunk.size());
+  Int32Reader reader(&column.metadata, column.element(), &stream);
+  vector<int32_t> result(values.size() + 1);
+  int64_t values_read = 0;
+  EXPECT_EQ(reader.ReadBatch(result.size(), NULL, NULL, &result[0], &values_read),
+      values.size());
+  EXPECT_EQ(values_read, values.size());
+  result.resize(values_read);
+  EXPECT_TRUE(result == values);
+}
+
+TEST(ColumnReader, Gzip) {
+  TestReadCompressedColumn(CompressionCodec::GZIP);
+}
+
+TEST(ColumnReader, Zstd) {
+  TestReadCompressedColumn(CompressionCodec::ZSTD);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
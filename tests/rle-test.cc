@@ -22,6 +22,8 @@
 
 #include "impala/rle-encoding.h"
 #include "impala/bit-stream-utils.inline.h"
+#include "impala/cpu-info.h"
+#include "impala/gather.h"
 
 using namespace impala;
 using namespace std;
@@ -292,6 +294,253 @@ TEST(Rle, BitWidthZeroLiteral) {
   EXPECT_FALSE(decoder.Get(&val));
 }
 
+// Decodes an encoding of 'values' with GetBatch() in batches of 'batch_size' and
+// checks the result matches.
+void ValidateGetBatch(const vector<int>& values, int bit_width, int batch_size) {
+  const int len = 64 * 1024;
+  uint8_t buffer[len];
+  RleEncoder encoder(buffer, len, bit_width);
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_TRUE(encoder.Put(values[i]));
+  }
+  int encoded_len = encoder.Flush();
+
+  // Literal runs are padded to a multiple of 8 values, so the decoder can return
+  // padding after the last value. Callers bound the reads by the number of values.
+  RleDecoder decoder(buffer, encoded_len, bit_width);
+  vector<int16_t> decoded(batch_size);
+  int num_decoded = 0;
+  while (num_decoded < values.size()) {
+    int n = min<int>(batch_size, values.size() - num_decoded);
+    EXPECT_EQ(decoder.GetBatch(&decoded[0], n), n);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(values[num_decoded + i], decoded[i]) << num_decoded + i;
+    }
+    num_decoded += n;
+  }
+  int16_t padding[8];
+  EXPECT_LT(decoder.GetBatch(padding, 8), 8);
+}
+
+TEST(Rle, GetBatch) {
+  vector<int> values;
+  for (int i = 0; i < 100; ++i) values.push_back(1);
+  for (int i = 0; i < 1000; ++i) values.push_back(i % 5);
+  for (int i = 0; i < 100; ++i) values.push_back(3);
+  for (int i = 0; i < 11; ++i) values.push_back(i % 2);
+
+  for (int width = 3; width <= 15; width += 4) {
+    int batch_sizes[] = { 1, 7, 8, 64, 100, 1024, 2000 };
+    for (int i = 0; i < sizeof(batch_sizes) / sizeof(int); ++i) {
+      ValidateGetBatch(values, width, batch_sizes[i]);
+    }
+  }
+}
+
+TEST(BitArray, GetBatch) {
+  const int len = 1024;
+  uint8_t buffer[len];
+  for (int width = 1; width <= MAX_WIDTH; ++width) {
+    const int num_values = len * 8 / width;
+    const uint64_t mod = 1LL << width;
+    BitWriter writer(buffer, len);
+    for (int i = 0; i < num_values; ++i) {
+      EXPECT_TRUE(writer.PutValue(i % mod, width));
+    }
+    writer.Flush();
+
+    BitReader reader(buffer, len);
+    vector<uint32_t> values(num_values + 10);
+    // An odd first batch so the rest are not aligned to 64 bits.
+    EXPECT_EQ(reader.GetBatch(width, &values[0], 3), 3);
+    EXPECT_EQ(reader.GetBatch(width, &values[3], num_values + 7), num_values - 3);
+    for (int i = 0; i < num_values; ++i) {
+      EXPECT_EQ(values[i], i % mod) << "width " << width << " value " << i;
+    }
+  }
+}
+
+// Encodes 'indices' and decodes them against a dictionary of 'T', for which
+// dictionary[i] = i * 3 + 1, 'batch_size' values at a time.
+template<typename T>
+void ValidateGetBatchWithDict(const vector<int>& indices, int bit_width,
+    int batch_size) {
+  const int len = 64 * 1024;
+  uint8_t buffer[len];
+  RleEncoder encoder(buffer, len, bit_width);
+  for (int i = 0; i < indices.size(); ++i) {
+    EXPECT_TRUE(encoder.Put(indices[i]));
+  }
+  int encoded_len = encoder.Flush();
+
+  vector<T> dictionary;
+  for (int i = 0; i < (1 << bit_width); ++i) dictionary.push_back(i * 3 + 1);
+
+  RleDecoder decoder(buffer, encoded_len, bit_width);
+  vector<T> values(indices.size());
+  int num_read = 0;
+  while (num_read < indices.size()) {
+    int n = std::min<int>(batch_size, indices.size() - num_read);
+    EXPECT_EQ(decoder.GetBatchWithDict(&dictionary[0], dictionary.size(),
+        &values[num_read], n), n);
+    num_read += n;
+  }
+  for (int i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(values[i], dictionary[indices[i]]) << "value " << i;
+  }
+}
+
+TEST(Rle, GetBatchWithDict) {
+  vector<int> indices;
+  for (int i = 0; i < 100; ++i) indices.push_back(1);
+  for (int i = 0; i < 3000; ++i) indices.push_back(i * 7 % 13);
+  for (int i = 0; i < 100; ++i) indices.push_back(3);
+  for (int i = 0; i < 11; ++i) indices.push_back(i % 2);
+
+  int batch_sizes[] = { 1, 7, 64, 100, 1500, 5000 };
+  for (int i = 0; i < sizeof(batch_sizes) / sizeof(int); ++i) {
+    ValidateGetBatchWithDict<int32_t>(indices, 4, batch_sizes[i]);
+    ValidateGetBatchWithDict<int64_t>(indices, 4, batch_sizes[i]);
+    ValidateGetBatchWithDict<float>(indices, 5, batch_sizes[i]);
+    ValidateGetBatchWithDict<double>(indices, 5, batch_sizes[i]);
+    ValidateGetBatchWithDict<int16_t>(indices, 4, batch_sizes[i]);
+  }
+}
+
+TEST(Rle, GetBatchWithDictOutOfRange) {
+  const int len = 1024;
+  uint8_t buffer[len];
+  int dictionary[] = { 10, 20, 30 };
+  int values[100];
+
+  // A literal run with one index past the dictionary.
+  RleEncoder literal_encoder(buffer, len, 3);
+  for (int i = 0; i < 100; ++i) EXPECT_TRUE(literal_encoder.Put(i == 50 ? 3 : i % 3));
+  int encoded_len = literal_encoder.Flush();
+  RleDecoder literal_decoder(buffer, encoded_len, 3);
+  EXPECT_EQ(literal_decoder.GetBatchWithDict(dictionary, 3, values, 100), -1);
+
+  // A repeated run of an index past the dictionary.
+  RleEncoder repeated_encoder(buffer, len, 3);
+  for (int i = 0; i < 100; ++i) EXPECT_TRUE(repeated_encoder.Put(5));
+  encoded_len = repeated_encoder.Flush();
+  RleDecoder repeated_decoder(buffer, encoded_len, 3);
+  EXPECT_EQ(repeated_decoder.GetBatchWithDict(dictionary, 3, values, 100), -1);
+}
+
+TEST(Gather, Lookup) {
+  vector<uint32_t> dict32;
+  vector<uint64_t> dict64;
+  for (int i = 0; i < 1000; ++i) {
+    dict32.push_back(i * 7);
+    dict64.push_back(i * 7 + (1LL << 40));
+  }
+  vector<int32_t> indices;
+  for (int i = 0; i < 1003; ++i) indices.push_back(i * 31 % 1000);
+
+  vector<uint32_t> out32(indices.size());
+  vector<uint64_t> out64(indices.size());
+  Gather::Lookup32Scalar(&dict32[0], &indices[0], &out32[0], indices.size());
+  Gather::Lookup64Scalar(&dict64[0], &indices[0], &out64[0], indices.size());
+  for (int i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(out32[i], dict32[indices[i]]);
+    EXPECT_EQ(out64[i], dict64[indices[i]]);
+  }
+
+  if (!CpuInfo::SupportsAvx2()) return;
+  out32.assign(indices.size(), 0);
+  out64.assign(indices.size(), 0);
+  Gather::Lookup32Avx2(&dict32[0], &indices[0], &out32[0], indices.size());
+  Gather::Lookup64Avx2(&dict64[0], &indices[0], &out64[0], indices.size());
+  for (int i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(out32[i], dict32[indices[i]]);
+    EXPECT_EQ(out64[i], dict64[indices[i]]);
+  }
+}
+
+// Skips 'num_skip' values of an encoding of 'values' and verifies the count of skipped
+// values equal to 'count_value' and that the rest of the values decode correctly.
+void ValidateSkip(const vector<int>& values, int bit_width, int num_skip,
+    int count_value) {
+  const int len = 64 * 1024;
+  uint8_t buffer[len];
+  RleEncoder encoder(buffer, len, bit_width);
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_TRUE(encoder.Put(values[i]));
+  }
+  int encoded_len = encoder.Flush();
+
+  RleDecoder decoder(buffer, encoded_len, bit_width);
+  EXPECT_EQ(decoder.Skip(num_skip), num_skip);
+  for (int i = num_skip; i < values.size(); ++i) {
+    uint64_t val;
+    EXPECT_TRUE(decoder.Get(&val));
+    EXPECT_EQ(values[i], val) << i;
+  }
+
+  int expected_count = 0;
+  for (int i = 0; i < num_skip; ++i) {
+    if (values[i] == count_value) ++expected_count;
+  }
+  RleDecoder counting_decoder(buffer, encoded_len, bit_width);
+  int count = 0;
+  EXPECT_EQ(counting_decoder.Skip(num_skip, count_value, &count), num_skip);
+  EXPECT_EQ(count, expected_count);
+  for (int i = num_skip; i < values.size(); ++i) {
+    uint64_t val;
+    EXPECT_TRUE(counting_decoder.Get(&val));
+    EXPECT_EQ(values[i], val) << i;
+  }
+}
+
+TEST(Rle, Skip) {
+  // A repeated run, a literal run and another repeated run.
+  vector<int> values;
+  for (int i = 0; i < 100; ++i) values.push_back(1);
+  for (int i = 0; i < 100; ++i) values.push_back(i % 3);
+  for (int i = 0; i < 100; ++i) values.push_back(0);
+
+  for (int width = 2; width <= 8; width += 3) {
+    ValidateSkip(values, width, 0, 1);
+    ValidateSkip(values, width, 1, 1);
+    ValidateSkip(values, width, 99, 1);
+    ValidateSkip(values, width, 100, 0);
+    ValidateSkip(values, width, 133, 2);
+    ValidateSkip(values, width, 250, 1);
+    ValidateSkip(values, width, values.size(), 0);
+  }
+
+  // Skipping past the end stops at the end.
+  const int len = 1024;
+  uint8_t buffer[len];
+  RleEncoder encoder(buffer, len, 1);
+  for (int i = 0; i < values.size(); ++i) encoder.Put(values[i] != 0);
+  int encoded_len = encoder.Flush();
+  RleDecoder decoder(buffer, encoded_len, 1);
+  EXPECT_EQ(decoder.Skip(values.size() + 10), values.size());
+}
+
+TEST(BitArray, SkipBits) {
+  const int len = 16;
+  uint8_t buffer[len];
+  BitWriter writer(buffer, len);
+  for (int i = 0; i < len * 8 / 4; ++i) writer.PutValue(i % 16, 4);
+  writer.Flush();
+
+  BitReader reader(buffer, len);
+  int val;
+  EXPECT_TRUE(reader.SkipBits(4 * 3));
+  EXPECT_TRUE(reader.GetValue(4, &val));
+  EXPECT_EQ(val, 3);
+  // Cross the 64 bit boundary of the reader's buffered values.
+  EXPECT_TRUE(reader.SkipBits(4 * 12));
+  EXPECT_TRUE(reader.GetValue(4, &val));
+  EXPECT_EQ(val, 0);
+  EXPECT_FALSE(reader.SkipBits(len * 8));
+  EXPECT_TRUE(reader.GetValue(4, &val));
+  EXPECT_EQ(val, 1);
+}
+
 // Test that writes out a repeated group and then a literal
 // group but flush before finishing.
 TEST(BitRle, Flush) {
@@ -18,6 +18,7 @@ else
       "gtest")      F_GTEST=1 ;;
       "lz4")        F_LZ4=1 ;;
       "snappy")     F_SNAPPY=1 ;;
+      "zstd")       F_ZSTD=1 ;;
       *)            echo "Unknown module: $arg"; exit 1 ;;
     esac
   done
@@ -70,6 +71,13 @@ if [ -n "$F_ALL" -o -n "$F_SNAPPY" ]; then
   make -j$PARALLEL install
 fi
 
+# build zstd
+if [ -n "$F_ALL" -o -n "$F_ZSTD" ]; then
+  cd $ZSTD_DIR/lib
+  echo "Building zstd"
+  CFLAGS="-O3 -fPIC" make -j$PARALLEL PREFIX=$PREFIX install
+fi
+
 echo "---------------------"
 echo "Thirdparty dependencies built and installed into $PREFIX successfully"
 
@@ -21,3 +21,10 @@ if [ ! -d gtest-${GTEST_VERSION} ]; then
   unzip gtest-${GTEST_VERSION}.zip
   rm gtest-${GTEST_VERSION}.zip
 fi
+
+if [ ! -d zstd-${ZSTD_VERSION} ]; then
+  echo "Fetching zstd"
+  curl -L -o zstd-${ZSTD_VERSION}.tar.gz https://github.com/facebook/zstd/archive/v${ZSTD_VERSION}.tar.gz
+  tar xzf zstd-${ZSTD_VERSION}.tar.gz
+  rm zstd-${ZSTD_VERSION}.tar.gz
+fi
@@ -7,3 +7,5 @@ GTEST_DIR=$TP_DIR/gtest-$GTEST_VERSION
 LZ4_VERSION=svn
 LZ4_DIR=$TP_DIR/lz4-$LZ4_VERSION
 
+ZSTD_VERSION=1.0.0
+ZSTD_DIR=$TP_DIR/zstd-$ZSTD_VERSION